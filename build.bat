@@ -8,17 +8,17 @@ where /q cl || (
 set warnings=/WX /W4 /wd4201 /wd4100 /wd4189 /wd4505 /wd4101 /wd4324 /wd4244
 set includes=/I ../my_lib/ /I ../external/raylib/
 set linkerFlags=/OUT:Main.exe /INCREMENTAL /CGTHREADS:6 /STACK:0x100000,0x100000 
-set linkerLibs=winmm.lib user32.lib shell32.lib gdi32.lib opengl32.lib
+set linkerLibs=winmm.lib user32.lib shell32.lib gdi32.lib opengl32.lib ws2_32.lib
 set compilerFlags=/std:c++20 /MP /arch:AVX2 /Oi /Ob3 /EHsc /fp:fast /fp:except- /nologo /GS- /Gs999999 /GR- /FC /Z7 
 
 if "%~1"=="-Debug" (
 	echo [[ debug build ]]
-	set compilerFlags=%compilerFlags% /Od /MTd /D_DEBUG
+	set compilerFlags=%compilerFlags% /Od /MTd /D_DEBUG /DTRACK_ALLOCATIONS
 	set rayname=d_raylib
 )
 if "%~1"=="" (
 	echo [[ debug build ]]
-	set compilerFlags=%compilerFlags% /Od /MTd /D_DEBUG
+	set compilerFlags=%compilerFlags% /Od /MTd /D_DEBUG /DTRACK_ALLOCATIONS
 	set rayname=d_raylib
 )
 if "%~1"=="-Release" (
@@ -31,13 +31,25 @@ IF NOT EXIST .\build mkdir .\build
 pushd .\build
 del *.pdb > NUL 2> NUL
 
-IF NOT EXIST %rayname%.lib (
+REM rebuild raylib whenever external/raylib/config.h differs from the copy taken at its last build;
+REM a stale lib would silently ignore flags like SUPPORT_CUSTOM_FRAME_CONTROL
+set buildraylib=0
+IF NOT EXIST %rayname%.lib set buildraylib=1
+fc /b ..\external\raylib\config.h %rayname%.config.h > NUL 2> NUL || set buildraylib=1
+
+IF "%buildraylib%"=="1" (
 echo building raylib
 REM Had to go to platforms directory and change path for GLFW include headers
-cl.exe /w /c /D PLATFORM_DESKTOP /D GRAPHICS_API_OPENGL_33 %compilerFlags% ../external/raylib/*.c
-lib /OUT:%rayname%.lib rcore.obj raudio.obj rglfw.obj rmodels.obj rshapes.obj rtext.obj rtextures.obj utils.obj
+REM config.h goes in first so that with TRACK_ALLOCATIONS its RL_MALLOC & co. win over raylib.h's defaults
+cl.exe /w /c /D PLATFORM_DESKTOP /D GRAPHICS_API_OPENGL_33 /FI ../external/raylib/config.h %compilerFlags% ../external/raylib/*.c || (popd & exit /b 1)
+lib /OUT:%rayname%.lib rcore.obj raudio.obj rglfw.obj rmodels.obj rshapes.obj rtext.obj rtextures.obj utils.obj || (popd & exit /b 1)
 del /Q *.obj
+copy /Y ..\external\raylib\config.h %rayname%.config.h > NUL
 )
 
-cl.exe %compilerFlags% %warnings% %includes% ../source/Main.cpp /link %linkerFlags% %rayname%.lib %linkerLibs%
+cl.exe %compilerFlags% %warnings% %includes% ../source/Main.cpp /link %linkerFlags% %rayname%.lib %linkerLibs% || (popd & exit /b 1)
+
+REM bake the assets the game loads (Pack::REQUIRED_ASSETS in source/Main.cpp) into one mmap-able bundle;
+REM fails the build if one of them is missing
+Main.exe --pack assets.pak .. || (popd & exit /b 1)
 popd
\ No newline at end of file
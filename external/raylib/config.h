@@ -69,7 +69,7 @@
 // Support custom frame control, only for advance users
 // By default EndDrawing() does this job: draws everything + SwapScreenBuffer() + manage frame timing + PollInputEvents()
 // Enabling this flag allows manual control of the frame processes, use at your own risk
-//#define SUPPORT_CUSTOM_FRAME_CONTROL    1
+#define SUPPORT_CUSTOM_FRAME_CONTROL    1
 
 // rcore: Configuration values
 //------------------------------------------------------------------------------------
@@ -251,4 +251,28 @@
 //------------------------------------------------------------------------------------
 #define MAX_TRACELOG_MSG_LENGTH       256       // Max length of one trace-log message
 
+//------------------------------------------------------------------------------------
+// Heap routing - debug builds of the game (TRACK_ALLOCATIONS)
+//------------------------------------------------------------------------------------
+// RL_MALLOC/RL_CALLOC/RL_REALLOC/RL_FREE go to the allocation tracker in source/Main.cpp (Memory), so
+// textures, images, shaders, fonts and text count under the game's tags. raylib.h only defines them
+// #ifndef, so build.bat force-includes this file (/FI) when it compiles raylib
+#if defined(TRACK_ALLOCATIONS)
+    #include <stddef.h>
+    #if defined(__cplusplus)
+    extern "C" {
+    #endif
+    void *RaylibMalloc(size_t size);
+    void *RaylibCalloc(size_t count, size_t size);
+    void *RaylibRealloc(void *ptr, size_t size);
+    void RaylibFree(void *ptr);
+    #if defined(__cplusplus)
+    }
+    #endif
+    #define RL_MALLOC(sz)       RaylibMalloc(sz)
+    #define RL_CALLOC(n,sz)     RaylibCalloc(n,sz)
+    #define RL_REALLOC(ptr,sz)  RaylibRealloc(ptr,sz)
+    #define RL_FREE(ptr)        RaylibFree(ptr)
+#endif
+
 #endif // CONFIG_H
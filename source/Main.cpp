@@ -1,20 +1,276 @@
 #include <vector>
+#include <array>
 #include <algorithm>
-#include <functional> 
+#include <functional>
 #include <memory>
+#include <new>
 #include <cstdlib>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
 #include <cmath>
 #include <ctime>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <cfloat>
+#include <cstddef>
+#include <filesystem>
+#include <string>
+#include <fstream>
+#if defined(__AVX__)
+#include <immintrin.h>
+#endif
 
 #include <raylib.h>
 #include <raymath.h>
+#include <rlgl.h>
+
+#if defined(_WIN32)
+// <windows.h> and <winsock2.h> clash with raylib names (CloseWindow, DrawText, Rectangle...), so only the
+// file mapping and UDP socket calls are declared (ws2_32.lib)
+extern "C" {
+	__declspec(dllimport) void* __stdcall CreateFileA(const char*, unsigned long, unsigned long, void*, unsigned long, unsigned long, void*);
+	__declspec(dllimport) void* __stdcall CreateFileMappingA(void*, void*, unsigned long, unsigned long, unsigned long, const char*);
+	__declspec(dllimport) void* __stdcall MapViewOfFile(void*, unsigned long, unsigned long, unsigned long, size_t);
+	__declspec(dllimport) int   __stdcall UnmapViewOfFile(const void*);
+	__declspec(dllimport) int   __stdcall GetFileSizeEx(void*, long long*);
+	__declspec(dllimport) int   __stdcall CloseHandle(void*);
+
+	__declspec(dllimport) int       __stdcall WSAStartup(unsigned short, void*);
+	__declspec(dllimport) uintptr_t __stdcall socket(int, int, int);
+	__declspec(dllimport) int       __stdcall bind(uintptr_t, const void*, int);
+	__declspec(dllimport) int       __stdcall getsockname(uintptr_t, void*, int*);
+	__declspec(dllimport) int       __stdcall ioctlsocket(uintptr_t, long, unsigned long*);
+	__declspec(dllimport) int       __stdcall sendto(uintptr_t, const char*, int, int, const void*, int);
+	__declspec(dllimport) int       __stdcall recvfrom(uintptr_t, char*, int, int, void*, int*);
+	__declspec(dllimport) int       __stdcall closesocket(uintptr_t);
+}
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <unistd.h>
+#endif
 
 // --- UTILS ---
 namespace Utils {
-	inline static float RandomFloat(float min, float max) {
-		return min + static_cast<float>(rand()) / RAND_MAX * (max - min);
+	// Per-world PRNG (xorshift64*). Every World owns one, so matches never share rand() state
+	struct Rng {
+		uint64_t state;
+
+		explicit Rng(uint64_t seed) {
+			// splitmix64 so that consecutive seeds give unrelated streams
+			uint64_t z = seed + 0x9E3779B97F4A7C15ull;
+			z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+			z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+			state = (z ^ (z >> 31)) | 1ull;
+		}
+
+		uint32_t Next() {
+			state ^= state >> 12;
+			state ^= state << 25;
+			state ^= state >> 27;
+			return static_cast<uint32_t>((state * 0x2545F4914F6CDD1Dull) >> 32);
+		}
+
+		float Float(float min, float max) {
+			return min + static_cast<float>(Next() >> 8) * (1.f / 16777216.f) * (max - min);
+		}
+
+		// inclusive on both ends, like GetRandomValue
+		int Int(int min, int max) {
+			return min + static_cast<int>(Next() % static_cast<uint32_t>(max - min + 1));
+		}
+	};
+}
+
+// --- MEMORY TRACKING ---
+// Opt-in: build with TRACK_ALLOCATIONS (build.bat does for debug builds) and the global operator new/delete
+// below count every C++ heap allocation under the subsystem tag active on the calling thread. raylib's
+// RL_MALLOC & co. come here too (Raylib* below, wired up in external/raylib/config.h), so its textures,
+// fonts and text buffers land under the same tags
+namespace Memory {
+	enum class Tag : uint8_t { UNTAGGED, ENTITIES, RENDERING, ASSETS, TEXT, NETWORK, COUNT };
+	static constexpr size_t TAG_COUNT = static_cast<size_t>(Tag::COUNT);
+	static constexpr const char* TAG_NAMES[TAG_COUNT] = { "untagged", "entities", "rendering", "assets", "text", "network" };
+
+#if defined(TRACK_ALLOCATIONS)
+	static constexpr bool ENABLED = true;
+#else
+	static constexpr bool ENABLED = false;
+#endif
+
+	struct Counters {
+		std::atomic<uint64_t> allocs{ 0 };
+		std::atomic<uint64_t> bytes{ 0 };
+		std::atomic<int64_t>  live{ 0 };     // bytes currently held
+	};
+
+	// constant-initialized, so usable by allocations made before main
+	inline Counters counters[TAG_COUNT];
+	inline thread_local Tag currentTag = Tag::UNTAGGED;
+
+	struct Totals {
+		uint64_t allocs = 0;
+		uint64_t bytes = 0;
+	};
+
+	static Totals Sum() {
+		Totals t;
+		for (const Counters& c : counters) {
+			t.allocs += c.allocs.load(std::memory_order_relaxed);
+			t.bytes += c.bytes.load(std::memory_order_relaxed);
+		}
+		return t;
+	}
+
+	// Allocations made on this thread while a Scope is alive are charged to its tag
+	class Scope {
+	public:
+		explicit Scope(Tag tag) : previous(currentTag) {
+			currentTag = tag;
+		}
+		~Scope() {
+			currentTag = previous;
+		}
+		Scope(const Scope&) = delete;
+		Scope& operator=(const Scope&) = delete;
+
+	private:
+		Tag previous;
+	};
+
+	// Allocation count and bytes between Begin and End, e.g. over one frame
+	class FrameCounter {
+	public:
+		void Begin() {
+			start = Sum();
+		}
+		void End() {
+			Totals now = Sum();
+			last = { now.allocs - start.allocs, now.bytes - start.bytes };
+			peak.allocs = std::max(peak.allocs, last.allocs);
+			peak.bytes = std::max(peak.bytes, last.bytes);
+		}
+		const Totals& Last() const { return last; }
+
+		void DrawOverlay(int x, int y) const {
+			if constexpr (!ENABLED) {
+				DrawText("Heap: build with TRACK_ALLOCATIONS", x, y, 10, LIGHTGRAY);
+			} else {
+				drawCounters(x, y);
+			}
+		}
+
+	private:
+		void drawCounters(int x, int y) const {
+			DrawText(TextFormat("Heap/frame: %llu allocs, %llu B (peak %llu, %llu B)",
+				static_cast<unsigned long long>(last.allocs), static_cast<unsigned long long>(last.bytes),
+				static_cast<unsigned long long>(peak.allocs), static_cast<unsigned long long>(peak.bytes)),
+				x, y, 10, last.allocs ? ORANGE : LIGHTGRAY);
+			for (size_t i = 0; i < TAG_COUNT; ++i) {
+				DrawText(TextFormat("  %-9s live %8.1f KB  total %llu allocs", TAG_NAMES[i],
+					counters[i].live.load(std::memory_order_relaxed) / 1024.0,
+					static_cast<unsigned long long>(counters[i].allocs.load(std::memory_order_relaxed))),
+					x, y + 12 * int(i + 1), 10, LIGHTGRAY);
+			}
+		}
+
+		Totals start;
+		Totals last;
+		Totals peak;
+	};
+
+#if defined(TRACK_ALLOCATIONS)
+	// Sits right before every tracked block; the block is over-allocated so any alignment fits after it
+	struct alignas(16) BlockHeader {
+		void*  raw;
+		size_t size;
+		Tag    tag;
+	};
+
+	static void* Allocate(size_t size, size_t align) noexcept {
+		align = std::max(align, alignof(BlockHeader));
+		unsigned char* raw = static_cast<unsigned char*>(malloc(size + sizeof(BlockHeader) + align));
+		if (!raw) return nullptr;
+		uintptr_t user = (reinterpret_cast<uintptr_t>(raw) + sizeof(BlockHeader) + align - 1) & ~(uintptr_t(align) - 1);
+		BlockHeader* header = reinterpret_cast<BlockHeader*>(user) - 1;
+		header->raw = raw;
+		header->size = size;
+		header->tag = currentTag;
+
+		Counters& c = counters[static_cast<size_t>(header->tag)];
+		c.allocs.fetch_add(1, std::memory_order_relaxed);
+		c.bytes.fetch_add(size, std::memory_order_relaxed);
+		c.live.fetch_add(static_cast<int64_t>(size), std::memory_order_relaxed);
+		return reinterpret_cast<void*>(user);
+	}
+
+	static void Release(void* ptr) noexcept {
+		if (!ptr) return;
+		BlockHeader* header = static_cast<BlockHeader*>(ptr) - 1;
+		counters[static_cast<size_t>(header->tag)].live.fetch_sub(static_cast<int64_t>(header->size), std::memory_order_relaxed);
+		free(header->raw);
+	}
+
+	static void* AllocateOrThrow(size_t size, size_t align) {
+		void* ptr = Allocate(size ? size : 1, align);
+		if (!ptr) throw std::bad_alloc();
+		return ptr;
+	}
+
+	static void* Reallocate(void* ptr, size_t size) noexcept {
+		if (!ptr) return Allocate(size ? size : 1, alignof(std::max_align_t));
+		if (size == 0) {
+			Release(ptr);
+			return nullptr;
+		}
+		void* moved = Allocate(size, alignof(std::max_align_t));
+		if (!moved) return nullptr;
+		memcpy(moved, ptr, std::min(size, (static_cast<BlockHeader*>(ptr) - 1)->size));
+		Release(ptr);
+		return moved;
 	}
+#endif
+}
+
+#if defined(TRACK_ALLOCATIONS)
+// raylib's allocator (see external/raylib/config.h); same blocks and tags as operator new
+extern "C" void* RaylibMalloc(size_t size) { return Memory::Allocate(size ? size : 1, alignof(std::max_align_t)); }
+extern "C" void* RaylibCalloc(size_t count, size_t size) {
+	size_t bytes = count * size;
+	void* ptr = Memory::Allocate(bytes ? bytes : 1, alignof(std::max_align_t));
+	if (ptr) memset(ptr, 0, bytes);
+	return ptr;
 }
+extern "C" void* RaylibRealloc(void* ptr, size_t size) { return Memory::Reallocate(ptr, size); }
+extern "C" void RaylibFree(void* ptr) { Memory::Release(ptr); }
+
+void* operator new(size_t size) { return Memory::AllocateOrThrow(size, alignof(std::max_align_t)); }
+void* operator new[](size_t size) { return Memory::AllocateOrThrow(size, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t align) { return Memory::AllocateOrThrow(size, static_cast<size_t>(align)); }
+void* operator new[](size_t size, std::align_val_t align) { return Memory::AllocateOrThrow(size, static_cast<size_t>(align)); }
+void* operator new(size_t size, const std::nothrow_t&) noexcept { return Memory::Allocate(size ? size : 1, alignof(std::max_align_t)); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept { return Memory::Allocate(size ? size : 1, alignof(std::max_align_t)); }
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return Memory::Allocate(size ? size : 1, static_cast<size_t>(align)); }
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept { return Memory::Allocate(size ? size : 1, static_cast<size_t>(align)); }
+
+void operator delete(void* ptr) noexcept { Memory::Release(ptr); }
+void operator delete[](void* ptr) noexcept { Memory::Release(ptr); }
+void operator delete(void* ptr, size_t) noexcept { Memory::Release(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { Memory::Release(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { Memory::Release(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { Memory::Release(ptr); }
+void operator delete(void* ptr, size_t, std::align_val_t) noexcept { Memory::Release(ptr); }
+void operator delete[](void* ptr, size_t, std::align_val_t) noexcept { Memory::Release(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { Memory::Release(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { Memory::Release(ptr); }
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { Memory::Release(ptr); }
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept { Memory::Release(ptr); }
+#endif
 
 // --- TRANSFORM, PHYSICS, LIFETIME, RENDERABLE ---
 struct TransformA {
@@ -31,6 +287,502 @@ struct Renderable {
 	enum Size { SMALL = 1, MEDIUM = 2, LARGE = 4, VERYLARGE = 8 } size = SMALL;   //rozmiary przeszkód
 };
 
+// --- WEAPONS ---
+enum class WeaponType { LASER, BULLET, SPREAD, BEAM, HOMING, COUNT };
+
+// How a projectile moves, collides and is drawn. Each kind lives in its own batch (see World)
+enum class ProjectileKind { LASER, BULLET, BEAM, MISSILE, COUNT };
+
+struct WeaponDesc {
+	const char*    name;
+	ProjectileKind kind;
+	float          fireRate;    // shots/sec
+	float          spacing;     // px between consecutive shots, projectile speed = spacing * fireRate
+	int            damage;
+	int            pellets;     // projectiles per shot
+	float          spread;      // fan angle in degrees the pellets are spread over
+	int            pierce;      // extra asteroids one projectile can pass through
+};
+
+static constexpr int WEAPON_COUNT = static_cast<int>(WeaponType::COUNT);
+static constexpr int MAX_PIERCE = 7;    // fire() clamps tuned pierce values to this
+static constexpr int PROJECTILE_KIND_COUNT = static_cast<int>(ProjectileKind::COUNT);
+
+// indexed by WeaponType
+static constexpr std::array<WeaponDesc, WEAPON_COUNT> WEAPONS = { {
+	{ "LASER",  ProjectileKind::LASER,   18.f,  40.f, 20, 1,  0.f, 0 },
+	{ "BULLET", ProjectileKind::BULLET,  22.f,  20.f, 10, 1,  0.f, 0 },
+	{ "SPREAD", ProjectileKind::BULLET,   8.f,  60.f,  8, 5, 40.f, 0 },
+	{ "BEAM",   ProjectileKind::BEAM,     6.f, 150.f, 25, 1,  0.f, 4 },
+	{ "HOMING", ProjectileKind::MISSILE,  4.f, 100.f, 40, 2, 30.f, 0 },
+} };
+static_assert(std::all_of(WEAPONS.begin(), WEAPONS.end(), [](const WeaponDesc& w) { return w.pierce <= MAX_PIERCE; }));
+
+// Compile-time per-kind behaviour, used by the World's projectile kernels instead of runtime branches
+template <ProjectileKind K> struct ProjectileTraits;
+template <> struct ProjectileTraits<ProjectileKind::LASER> {
+	static constexpr float RADIUS = 2.f;
+	static constexpr bool  PIERCE = false;
+	static constexpr bool  HOMING = false;
+	static constexpr float LENGTH = 30.f;    // drawn and collided as a vertical segment above position
+	static constexpr float LIGHT_RADIUS = 70.f;
+	static constexpr Color LIGHT_COLOR = RED;
+};
+template <> struct ProjectileTraits<ProjectileKind::BULLET> {
+	static constexpr float RADIUS = 5.f;
+	static constexpr bool  PIERCE = false;
+	static constexpr bool  HOMING = false;
+	static constexpr float LENGTH = 0.f;
+	static constexpr float LIGHT_RADIUS = 45.f;
+	static constexpr Color LIGHT_COLOR = { 255, 235, 190, 255 };
+};
+template <> struct ProjectileTraits<ProjectileKind::BEAM> {
+	static constexpr float RADIUS = 3.f;
+	static constexpr bool  PIERCE = true;
+	static constexpr bool  HOMING = false;
+	static constexpr float LENGTH = 80.f;
+	static constexpr float LIGHT_RADIUS = 110.f;
+	static constexpr Color LIGHT_COLOR = SKYBLUE;
+};
+template <> struct ProjectileTraits<ProjectileKind::MISSILE> {
+	static constexpr float RADIUS = 4.f;
+	static constexpr bool  PIERCE = false;
+	static constexpr bool  HOMING = true;
+	static constexpr float LENGTH = 0.f;
+	static constexpr float TURN_RATE = 6.f;      // how fast velocity bends towards the target, 1/s
+	static constexpr float SEEK_RANGE = 600.f;
+	static constexpr float LIGHT_RADIUS = 80.f;
+	static constexpr Color LIGHT_COLOR = ORANGE;
+};
+
+// --- TUNING ---
+// Balance knobs. Per-size arrays are indexed SMALL, MEDIUM, LARGE, VERYLARGE (see SizeIndex)
+struct Tuning {
+	int   spawnWeights[4] = { 40, 25, 20, 15 };    // triangle, square, pentagon, verylarge
+	int   hp[4]           = { 10, 50, 200, 500 };
+	int   baseDamage[4]   = { 5, 10, 15, 10 };
+	int   fragments[4]    = { 0, 0, 2, 2 };        // pieces of the next smaller shape left when destroyed
+	float spawnInterval[2] = { 0.5f, 3.0f };      // seconds between edge spawns, min and max
+	int   maxAsteroids    = 150;                   // edge spawns wait while this many are alive, up to World::C_MAX_ASTEROIDS
+	std::array<WeaponDesc, WEAPON_COUNT> weapons = WEAPONS;
+};
+
+inline static int SizeIndex(Renderable::Size size) {
+	switch (size) {
+		case Renderable::SMALL: return 0;
+		case Renderable::MEDIUM: return 1;
+		case Renderable::LARGE: return 2;
+		default: return 3;
+	}
+}
+
+// --- STARFIELD ---
+// Parallax background. Star quads are generated once into a static vertex buffer per layer;
+// scrolling and twinkling happen in the vertex shader, so a frame costs a few uniforms and one
+// draw call per layer
+class Starfield {
+public:
+	void Init(int w, int h) {
+		shader = LoadShaderFromMemory(VS, FS);
+		resolutionLoc = GetShaderLocation(shader, "resolution");
+		timeLoc = GetShaderLocation(shader, "time");
+		offsetLoc = GetShaderLocation(shader, "offset");
+		sizeScaleLoc = GetShaderLocation(shader, "sizeScale");
+		brightnessLoc = GetShaderLocation(shader, "brightness");
+		tintLoc = GetShaderLocation(shader, "tint");
+		resolution = { static_cast<float>(w), static_cast<float>(h) };
+
+		Utils::Rng rng(SEED);
+		std::vector<StarVertex> vertices;
+		for (Layer& layer : layers) {
+			vertices.clear();
+			for (int i = 0; i < layer.stars; ++i) {
+				float x = rng.Float(0, 1);
+				float y = rng.Float(0, 1);
+				float size = rng.Float(0.6f, 1.6f);
+				float phase = rng.Float(0, 2 * PI);
+				float rate = rng.Float(0.5f, 4.f);
+				for (Vector2 c : QUAD) {
+					vertices.push_back({ x, y, c.x, c.y, size, phase, rate });
+				}
+			}
+			layer.vertexCount = static_cast<int>(vertices.size());
+			layer.vao = rlLoadVertexArray();
+			rlEnableVertexArray(layer.vao);
+			layer.vbo = rlLoadVertexBuffer(vertices.data(), static_cast<int>(vertices.size() * sizeof(StarVertex)), false);
+			rlSetVertexAttribute(0, 2, RL_FLOAT, false, sizeof(StarVertex), reinterpret_cast<const void*>(offsetof(StarVertex, x)));
+			rlEnableVertexAttribute(0);
+			rlSetVertexAttribute(1, 2, RL_FLOAT, false, sizeof(StarVertex), reinterpret_cast<const void*>(offsetof(StarVertex, cornerX)));
+			rlEnableVertexAttribute(1);
+			rlSetVertexAttribute(2, 3, RL_FLOAT, false, sizeof(StarVertex), reinterpret_cast<const void*>(offsetof(StarVertex, size)));
+			rlEnableVertexAttribute(2);
+			rlDisableVertexArray();
+		}
+	}
+
+	void Unload() {
+		for (Layer& layer : layers) {
+			rlUnloadVertexArray(layer.vao);
+			rlUnloadVertexBuffer(layer.vbo);
+		}
+		UnloadShader(shader);
+	}
+
+	void Draw(double time) {
+		rlDrawRenderBatchActive();    // flush whatever raylib has batched so far (the clear)
+		rlSetBlendMode(RL_BLEND_ADDITIVE);
+		rlEnableShader(shader.id);
+
+		float twinkleTime = static_cast<float>(fmod(time, 1000.0));
+		SetShaderValue(shader, resolutionLoc, &resolution, SHADER_UNIFORM_VEC2);
+		SetShaderValue(shader, timeLoc, &twinkleTime, SHADER_UNIFORM_FLOAT);
+		for (const Layer& layer : layers) {
+			// wrapped on the CPU in double precision so stars don't jitter after long sessions
+			float offset = static_cast<float>(fmod(time * layer.scroll, 1.0));
+			SetShaderValue(shader, offsetLoc, &offset, SHADER_UNIFORM_FLOAT);
+			SetShaderValue(shader, sizeScaleLoc, &layer.sizeScale, SHADER_UNIFORM_FLOAT);
+			SetShaderValue(shader, brightnessLoc, &layer.brightness, SHADER_UNIFORM_FLOAT);
+			SetShaderValue(shader, tintLoc, &layer.tint, SHADER_UNIFORM_VEC3);
+			rlEnableVertexArray(layer.vao);
+			rlDrawVertexArray(0, layer.vertexCount);
+		}
+
+		rlDisableVertexArray();
+		rlDisableShader();
+		rlSetBlendMode(RL_BLEND_ALPHA);
+	}
+
+private:
+	struct StarVertex {
+		float x, y;                  // 0..1 across the screen
+		float cornerX, cornerY;      // -1..1 quad corner
+		float size, phase, rate;     // px, twinkle phase, twinkle speed
+	};
+
+	struct Layer {
+		int     stars;
+		float   scroll;        // screen heights per second
+		float   sizeScale;
+		float   brightness;
+		Vector3 tint;
+		unsigned int vao = 0;
+		unsigned int vbo = 0;
+		int     vertexCount = 0;
+	};
+
+	// two triangles
+	static constexpr Vector2 QUAD[6] = { { -1, -1 }, { 1, -1 }, { 1, 1 }, { -1, -1 }, { 1, 1 }, { -1, 1 } };
+	static constexpr uint64_t SEED = 0x5A7F1E1Dull;
+
+	static constexpr const char* VS = R"(#version 330
+layout(location = 0) in vec2 starPos;
+layout(location = 1) in vec2 corner;
+layout(location = 2) in vec3 starParams;
+uniform vec2 resolution;
+uniform float time;
+uniform float offset;
+uniform float sizeScale;
+uniform float brightness;
+out vec2 fragCorner;
+out float fragAlpha;
+void main() {
+	vec2 p = vec2(starPos.x, fract(starPos.y + offset))*resolution + corner*starParams.x*sizeScale;
+	gl_Position = vec4(p.x/resolution.x*2.0 - 1.0, 1.0 - p.y/resolution.y*2.0, 0.0, 1.0);
+	fragCorner = corner;
+	fragAlpha = brightness*(0.55 + 0.45*sin(time*starParams.z + starParams.y));
+}
+)";
+
+	static constexpr const char* FS = R"(#version 330
+in vec2 fragCorner;
+in float fragAlpha;
+uniform vec3 tint;
+out vec4 finalColor;
+void main() {
+	float a = fragAlpha*(1.0 - smoothstep(0.2, 1.0, length(fragCorner)));
+	finalColor = vec4(tint, a);
+}
+)";
+
+	Shader  shader{};
+	int     resolutionLoc = -1;
+	int     timeLoc = -1;
+	int     offsetLoc = -1;
+	int     sizeScaleLoc = -1;
+	int     brightnessLoc = -1;
+	int     tintLoc = -1;
+	Vector2 resolution{};
+
+	// far to near
+	std::array<Layer, 3> layers = { {
+		{ 24000, 0.004f, 1.0f, 0.5f, { 0.7f, 0.75f, 1.0f } },
+		{ 12000, 0.012f, 1.6f, 0.7f, { 0.9f, 0.9f, 1.0f } },
+		{  4000, 0.035f, 2.4f, 1.0f, { 1.0f, 0.95f, 0.85f } },
+	} };
+};
+
+// --- LIGHTING ---
+// Tiled 2D point lights. The scene is drawn into an offscreen target; lights are binned on the CPU into
+// screen tiles with a counting sort, the light list, per-tile ranges and the flat index list go up as
+// float textures (GL 3.3 has no storage buffers), and one full-screen pass shades each pixel with only
+// the lights of its tile. Cost follows lights per tile, not lights on screen
+class Lighting {
+public:
+	static constexpr int    TILE = 32;                 // px
+	static constexpr size_t MAX_LIGHTS = 16384;
+	static constexpr int    MAX_PER_TILE = 128;        // extra lights in a crowded tile are dropped
+	static constexpr int    TEX_W = 1024;              // row width of the light and index textures
+	static constexpr size_t MAX_INDICES = size_t(TEX_W) * 512;    // (tile, light) pairs, 2 MB of R32F
+
+	struct Stats {
+		int    lights = 0;
+		int    dropped = 0;       // over MAX_LIGHTS, a full tile or the index budget
+		int    litTiles = 0;
+		int    maxPerTile = 0;
+		double perLitTile = 0.0;
+		double binMs = 0.0;
+	};
+
+	void Init(int w, int h) {
+		width = w;
+		height = h;
+		tilesX = (w + TILE - 1) / TILE;
+		tilesY = (h + TILE - 1) / TILE;
+		scene = LoadRenderTexture(w, h);
+		shader = LoadShaderFromMemory(nullptr, FS);
+		lightDataLoc = GetShaderLocation(shader, "lightData");
+		tileDataLoc = GetShaderLocation(shader, "tileData");
+		lightIndexLoc = GetShaderLocation(shader, "lightIndex");
+		tileSizeLoc = GetShaderLocation(shader, "tileSize");
+		screenHeightLoc = GetShaderLocation(shader, "screenHeight");
+		ambientLoc = GetShaderLocation(shader, "ambient");
+
+		lightTex = FloatTexture(TEX_W, static_cast<int>(MAX_LIGHTS * 2 / TEX_W), RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32A32);
+		tileTex = FloatTexture(tilesX, tilesY, RL_PIXELFORMAT_UNCOMPRESSED_R32G32B32);
+		indexTex = FloatTexture(TEX_W, static_cast<int>(MAX_INDICES / TEX_W), RL_PIXELFORMAT_UNCOMPRESSED_R32);
+
+		// everything is sized up front so a frame never touches the heap
+		lights.reserve(MAX_LIGHTS);
+		lightTexels.resize(MAX_LIGHTS * 8);
+		tileCount.resize(static_cast<size_t>(tilesX * tilesY));
+		tileFill.resize(tileCount.size());
+		tileTexels.resize(tileCount.size() * 3);
+		indices.resize(MAX_INDICES);
+	}
+
+	void Unload() {
+		UnloadRenderTexture(scene);
+		UnloadShader(shader);
+		rlUnloadTexture(lightTex.id);
+		rlUnloadTexture(tileTex.id);
+		rlUnloadTexture(indexTex.id);
+	}
+
+	// Starts the offscreen scene; everything drawn until Resolve gets lit
+	void Begin() {
+		lights.clear();
+		active = enabled;
+		if (active) BeginTextureMode(scene);
+	}
+
+	void Add(Vector2 position, float radius, Color color, float intensity = 1.f) {
+		if (!active) return;
+		if (lights.size() == MAX_LIGHTS) {
+			++overflow;
+			return;
+		}
+		lights.push_back({ position, radius, color, intensity });
+	}
+
+	// Bins, uploads and composites the lit scene onto the back buffer
+	void Resolve() {
+		if (!active) return;
+		EndTextureMode();
+		auto start = std::chrono::steady_clock::now();
+		int indexCount = bin();
+		stats.binMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+		int lightRows = (static_cast<int>(lights.size()) * 2 + TEX_W - 1) / TEX_W;
+		int indexRows = (indexCount + TEX_W - 1) / TEX_W;
+		if (lightRows > 0) rlUpdateTexture(lightTex.id, 0, 0, TEX_W, lightRows, lightTex.format, lightTexels.data());
+		if (indexRows > 0) rlUpdateTexture(indexTex.id, 0, 0, TEX_W, indexRows, indexTex.format, indices.data());
+		rlUpdateTexture(tileTex.id, 0, 0, tilesX, tilesY, tileTex.format, tileTexels.data());
+
+		BeginShaderMode(shader);
+		SetShaderValueTexture(shader, lightDataLoc, lightTex);
+		SetShaderValueTexture(shader, tileDataLoc, tileTex);
+		SetShaderValueTexture(shader, lightIndexLoc, indexTex);
+		int tileSize = TILE;
+		float screenHeight = static_cast<float>(height);
+		SetShaderValue(shader, tileSizeLoc, &tileSize, SHADER_UNIFORM_INT);
+		SetShaderValue(shader, screenHeightLoc, &screenHeight, SHADER_UNIFORM_FLOAT);
+		SetShaderValue(shader, ambientLoc, &ambient, SHADER_UNIFORM_FLOAT);
+		// render textures are stored bottom-up
+		DrawTextureRec(scene.texture, { 0, 0, static_cast<float>(width), -static_cast<float>(height) }, { 0, 0 }, WHITE);
+		EndShaderMode();
+		active = false;
+	}
+
+	void Toggle() { enabled = !enabled; }
+	bool Enabled() const { return enabled; }
+	const Stats& GetStats() const { return stats; }
+
+	void DrawOverlay(int x, int y) const {
+		if (!enabled) {
+			DrawText("Lighting: off (F5)", x, y, 10, LIGHTGRAY);
+			return;
+		}
+		DrawText(TextFormat("Lighting (F5): %d lights, %d dropped | %d/%d tiles lit, %.1f lights per lit tile, %d max | bin %.2f ms",
+			stats.lights, stats.dropped, stats.litTiles, tilesX * tilesY, stats.perLitTile, stats.maxPerTile, stats.binMs), x, y, 10, LIGHTGRAY);
+	}
+
+private:
+	struct Light {
+		Vector2 position;
+		float   radius;
+		Color   color;
+		float   intensity;
+	};
+
+	static Texture2D FloatTexture(int w, int h, int format) {
+		Texture2D tex{};
+		tex.id = rlLoadTexture(nullptr, w, h, format, 1);
+		tex.width = w;
+		tex.height = h;
+		tex.mipmaps = 1;
+		tex.format = format;
+		return tex;
+	}
+
+	// Counting sort of (tile, light) pairs into per-tile ranges of `indices`; returns the index count
+	int bin() {
+		std::fill(tileCount.begin(), tileCount.end(), 0);
+		stats = {};
+		stats.lights = static_cast<int>(lights.size());
+		stats.dropped = overflow;
+		overflow = 0;
+
+		auto tileRange = [&](const Light& l, int& x0, int& y0, int& x1, int& y1) {
+			x0 = std::max(0, static_cast<int>(floorf((l.position.x - l.radius) / TILE)));
+			y0 = std::max(0, static_cast<int>(floorf((l.position.y - l.radius) / TILE)));
+			x1 = std::min(tilesX - 1, static_cast<int>(floorf((l.position.x + l.radius) / TILE)));
+			y1 = std::min(tilesY - 1, static_cast<int>(floorf((l.position.y + l.radius) / TILE)));
+		};
+
+		for (size_t i = 0; i < lights.size(); ++i) {
+			const Light& l = lights[i];
+			float* t = &lightTexels[i * 8];
+			t[0] = l.position.x;
+			t[1] = l.position.y;
+			t[2] = l.radius;
+			t[3] = 0.f;
+			t[4] = l.color.r / 255.f;
+			t[5] = l.color.g / 255.f;
+			t[6] = l.color.b / 255.f;
+			t[7] = l.intensity;
+
+			int x0, y0, x1, y1;
+			tileRange(l, x0, y0, x1, y1);
+			for (int ty = y0; ty <= y1; ++ty) {
+				for (int tx = x0; tx <= x1; ++tx) {
+					int& count = tileCount[static_cast<size_t>(ty * tilesX + tx)];
+					if (count < MAX_PER_TILE) ++count;
+					else ++stats.dropped;
+				}
+			}
+		}
+
+		int total = 0;
+		for (size_t tile = 0; tile < tileCount.size(); ++tile) {
+			int count = std::min(tileCount[tile], static_cast<int>(MAX_INDICES) - total);
+			stats.dropped += tileCount[tile] - count;
+			tileFill[tile] = total;
+			tileCount[tile] = total + count;    // from here on, where the tile's range ends
+			tileTexels[tile * 3 + 0] = static_cast<float>(total);
+			tileTexels[tile * 3 + 1] = static_cast<float>(count);
+			tileTexels[tile * 3 + 2] = 0.f;
+			total += count;
+			if (count > 0) ++stats.litTiles;
+			stats.maxPerTile = std::max(stats.maxPerTile, count);
+		}
+		stats.perLitTile = stats.litTiles ? double(total) / stats.litTiles : 0.0;
+
+		for (size_t i = 0; i < lights.size(); ++i) {
+			int x0, y0, x1, y1;
+			tileRange(lights[i], x0, y0, x1, y1);
+			for (int ty = y0; ty <= y1; ++ty) {
+				for (int tx = x0; tx <= x1; ++tx) {
+					size_t tile = static_cast<size_t>(ty * tilesX + tx);
+					if (tileFill[tile] < tileCount[tile]) indices[static_cast<size_t>(tileFill[tile]++)] = static_cast<float>(i);
+				}
+			}
+		}
+		return total;
+	}
+
+	// Scene colour lit by ambient + the tile's lights, plus a little of the light itself as glow so
+	// lights show on the empty background too
+	static constexpr const char* FS = R"(#version 330
+in vec2 fragTexCoord;
+in vec4 fragColor;
+uniform sampler2D texture0;
+uniform sampler2D lightData;
+uniform sampler2D tileData;
+uniform sampler2D lightIndex;
+uniform int tileSize;
+uniform float screenHeight;
+uniform float ambient;
+out vec4 finalColor;
+const int TEX_W = 1024;
+void main() {
+	vec4 albedo = texture(texture0, fragTexCoord);
+	vec2 p = vec2(gl_FragCoord.x, screenHeight - gl_FragCoord.y);
+	vec2 range = texelFetch(tileData, ivec2(p) / tileSize, 0).xy;
+	int first = int(range.x);
+	int count = int(range.y);
+	vec3 light = vec3(0.0);
+	for (int i = 0; i < count; ++i) {
+		int slot = first + i;
+		int index = int(texelFetch(lightIndex, ivec2(slot % TEX_W, slot / TEX_W), 0).r)*2;
+		vec4 shape = texelFetch(lightData, ivec2(index % TEX_W, index / TEX_W), 0);
+		vec4 color = texelFetch(lightData, ivec2(index % TEX_W + 1, index / TEX_W), 0);
+		float falloff = clamp(1.0 - length(p - shape.xy)/shape.z, 0.0, 1.0);
+		light += color.rgb*color.a*falloff*falloff;
+	}
+	finalColor = vec4(albedo.rgb*(ambient + light) + light*0.25, 1.0);
+}
+)";
+
+	int width = 0;
+	int height = 0;
+	int tilesX = 0;
+	int tilesY = 0;
+	bool enabled = true;
+	bool active = false;
+	float ambient = 0.8f;
+	int overflow = 0;
+	Stats stats;
+
+	RenderTexture2D scene{};
+	Shader    shader{};
+	Texture2D lightTex{};
+	Texture2D tileTex{};
+	Texture2D indexTex{};
+	int lightDataLoc = -1;
+	int tileDataLoc = -1;
+	int lightIndexLoc = -1;
+	int tileSizeLoc = -1;
+	int screenHeightLoc = -1;
+	int ambientLoc = -1;
+
+	std::vector<Light> lights;
+	std::vector<float> lightTexels;    // two RGBA texels per light: x, y, radius, - | r, g, b, intensity
+	std::vector<int>   tileCount;
+	std::vector<int>   tileFill;
+	std::vector<float> tileTexels;     // first index, count, -
+	std::vector<float> indices;
+};
+
 // --- RENDERER ---
 class Renderer {
 public:
@@ -41,26 +793,42 @@ public:
 
 	void Init(int w, int h, const char* title) {
 		InitWindow(w, h, title);
-		SetTargetFPS(60);
 		screenW = w;
 		screenH = h;
+		starfield.Init(w, h);
+		lighting.Init(w, h);
 	}
 
 	//change the background
 	void Begin() {
     BeginDrawing();
+    lighting.Begin();
     float time = GetTime();
     float periodDuration = 10.0f;
-    float t = fmodf(time, periodDuration) / periodDuration; 
+    float t = fmodf(time, periodDuration) / periodDuration;
     float hue = 210.0f + t * (270.0f - 210.0f);
     Color bg = ColorFromHSV(hue, 0.6f, 0.2f);
     ClearBackground(bg);
+    starfield.Draw(GetTime());
+	}
+
+	// Lit scene ends here; whatever is drawn after (HUD) goes straight to the screen
+	void Resolve() {
+		lighting.Resolve();
 	}
 
 	void End() {
 		EndDrawing();
 	}
 
+	void AddLight(Vector2 position, float radius, Color color) {
+		lighting.Add(position, radius, color);
+	}
+
+	Lighting& Lights() {
+		return lighting;
+	}
+
 	void DrawPoly(const Vector2& pos, int sides, float radius, float rot) {
 		DrawPolyLines(pos, sides, radius, rot, WHITE);
 	}
@@ -78,22 +846,172 @@ private:
 
 	int screenW{};
 	int screenH{};
+	Starfield starfield;
+	Lighting lighting;
 };
 
+// --- POLYGON GEOMETRY ---
+// Narrowphase shapes matching what Renderer::DrawPoly draws: regular polygons whose vertex 0 sits at
+// the rotation angle (same convention as DrawPolyLines)
+namespace Geometry {
+	static constexpr double PI_D = 3.14159265358979323846;
+	static constexpr int MAX_SIDES = 8;
+
+	// Taylor series; std::sin is not constexpr, and the unit tables are baked at compile time
+	constexpr double Sin(double x) {
+		while (x > PI_D) x -= 2 * PI_D;
+		while (x < -PI_D) x += 2 * PI_D;
+		double term = x;
+		double sum = x;
+		for (int i = 1; i < 12; ++i) {
+			term *= -x * x / ((2.0 * i) * (2.0 * i + 1.0));
+			sum += term;
+		}
+		return sum;
+	}
+
+	constexpr double Cos(double x) {
+		return Sin(x + PI_D / 2);
+	}
+
+	// Circumradius 1, padded to MAX_SIDES by repeating the last vertex/normal, which changes no min/max test
+	struct UnitPolygon {
+		float vx[MAX_SIDES];
+		float vy[MAX_SIDES];
+		float nx[MAX_SIDES];    // outward normal of edge v[i] -> v[i+1]
+		float ny[MAX_SIDES];
+		float apothem;
+	};
+
+	constexpr UnitPolygon MakeUnitPolygon(int sides) {
+		UnitPolygon poly{};
+		double step = 2 * PI_D / sides;
+		for (int i = 0; i < MAX_SIDES; ++i) {
+			int k = i < sides ? i : sides - 1;
+			poly.vx[i] = static_cast<float>(Cos(k * step));
+			poly.vy[i] = static_cast<float>(Sin(k * step));
+			poly.nx[i] = static_cast<float>(Cos((k + 0.5) * step));
+			poly.ny[i] = static_cast<float>(Sin((k + 0.5) * step));
+		}
+		poly.apothem = static_cast<float>(Cos(PI_D / sides));
+		return poly;
+	}
+
+	static constexpr UnitPolygon TRIANGLE = MakeUnitPolygon(3);
+	static constexpr UnitPolygon SQUARE = MakeUnitPolygon(4);
+	static constexpr UnitPolygon PENTAGON = MakeUnitPolygon(5);
+	static constexpr UnitPolygon OCTAGON = MakeUnitPolygon(8);
+
+	constexpr const UnitPolygon& UnitPolygonFor(int sides) {
+		switch (sides) {
+			case 3: return TRIANGLE;
+			case 4: return SQUARE;
+			case 5: return PENTAGON;
+			default: return OCTAGON;
+		}
+	}
+
+	// Unit polygon rotated and scaled for the current frame, relative to the shape's center
+	struct alignas(32) Hull {
+		float vx[MAX_SIDES];
+		float vy[MAX_SIDES];
+		float nx[MAX_SIDES];
+		float ny[MAX_SIDES];
+		float apothem;
+		float minX;    // x extent of the vertices
+		float maxX;
+
+		void Set(const UnitPolygon& unit, float radius, float rotationDeg) {
+			float c = cosf(rotationDeg * DEG2RAD);
+			float s = sinf(rotationDeg * DEG2RAD);
+			minX = FLT_MAX;
+			maxX = -FLT_MAX;
+			for (int i = 0; i < MAX_SIDES; ++i) {
+				vx[i] = (unit.vx[i] * c - unit.vy[i] * s) * radius;
+				vy[i] = (unit.vx[i] * s + unit.vy[i] * c) * radius;
+				nx[i] = unit.nx[i] * c - unit.ny[i] * s;
+				ny[i] = unit.nx[i] * s + unit.ny[i] * c;
+				minX = fminf(minX, vx[i]);
+				maxX = fmaxf(maxX, vx[i]);
+			}
+			apothem = unit.apothem * radius;
+		}
+	};
+
+	// Squared distance from p to the vertical segment x = x, y in [yTop, yBottom] (lasers and beams)
+	inline static float VerticalSegmentDistanceSqr(float x, float yTop, float yBottom, Vector2 p) {
+		float dx = p.x - x;
+		float dy = p.y - Clamp(p.y, yTop, yBottom);
+		return dx * dx + dy * dy;
+	}
+
+	// Circle (p, r) against the hull, p relative to the hull center. Separating-axis test over the
+	// edge normals; corners are treated as the radius-expanded half-planes, which is exact for r -> 0
+	inline static bool CircleOverlaps(const Hull& h, Vector2 p, float r) {
+#if defined(__AVX__)
+		__m256 d = _mm256_sub_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_load_ps(h.nx), _mm256_set1_ps(p.x)),
+			_mm256_mul_ps(_mm256_load_ps(h.ny), _mm256_set1_ps(p.y))), _mm256_set1_ps(h.apothem));
+		return _mm256_movemask_ps(_mm256_cmp_ps(d, _mm256_set1_ps(r), _CMP_GT_OQ)) == 0;
+#else
+		bool separated = false;
+		for (int i = 0; i < MAX_SIDES; ++i) {
+			separated |= h.nx[i] * p.x + h.ny[i] * p.y - h.apothem > r;
+		}
+		return !separated;
+#endif
+	}
+
+	// Vertical capsule (x, yTop..yBottom, r) against the hull, relative to the hull center - lasers and
+	// beams. Axes are the edge normals (both endpoints outside the same edge) plus the segment normal,
+	// which for a vertical segment is just the hull's x extent
+	inline static bool VerticalSegmentOverlaps(const Hull& h, float x, float yTop, float yBottom, float r) {
+		if (x - r > h.maxX || x + r < h.minX) return false;
+#if defined(__AVX__)
+		__m256 ny = _mm256_load_ps(h.ny);
+		__m256 base = _mm256_sub_ps(_mm256_mul_ps(_mm256_load_ps(h.nx), _mm256_set1_ps(x)), _mm256_set1_ps(h.apothem));
+		__m256 nearer = _mm256_min_ps(_mm256_mul_ps(ny, _mm256_set1_ps(yTop)), _mm256_mul_ps(ny, _mm256_set1_ps(yBottom)));
+		return _mm256_movemask_ps(_mm256_cmp_ps(_mm256_add_ps(base, nearer), _mm256_set1_ps(r), _CMP_GT_OQ)) == 0;
+#else
+		bool separated = false;
+		for (int i = 0; i < MAX_SIDES; ++i) {
+			float nearer = fminf(h.ny[i] * yTop, h.ny[i] * yBottom);
+			separated |= h.nx[i] * x - h.apothem + nearer > r;
+		}
+		return !separated;
+#endif
+	}
+}
+
 // --- ASTEROID HIERARCHY ---
 
 class Asteroid {
 public:
-	Asteroid(int screenW, int screenH) {
-		init(screenW, screenH);
-	}
+	Asteroid() = default;
 	virtual ~Asteroid() = default;
 
-	bool Update(float dt) {
+	// (Re)initialises the asteroid at a random screen edge, aimed at the center. Objects are reused
+	// by the World's pool, so this and SpawnFragment reset all per-life state
+	void SpawnAtEdge(int screenW, int screenH, Utils::Rng& rng, const Tuning& tuning) {
+		init(screenW, screenH, rng);
+		applyTuning(tuning);
+		removed = false;
+	}
+
+	void SpawnFragment(Vector2 position, Vector2 velocity, Utils::Rng& rng, const Tuning& tuning) {
+		transform.position = position;
+		transform.rotation = rng.Float(0, 360);
+		physics.velocity = velocity;
+		physics.rotationSpeed = rng.Float(ROT_MIN, ROT_MAX);
+		applyTuning(tuning);
+		removed = false;
+	}
+
+	bool Update(float dt, int screenW, int screenH) {
 		transform.position = Vector2Add(transform.position, Vector2Scale(physics.velocity, dt));
 		transform.rotation += physics.rotationSpeed * dt;
-		if (transform.position.x < -GetRadius() || transform.position.x > Renderer::Instance().Width() + GetRadius() ||
-			transform.position.y < -GetRadius() || transform.position.y > Renderer::Instance().Height() + GetRadius())
+		hull.Set(Geometry::UnitPolygonFor(sides), GetRadius(), transform.rotation);
+		if (transform.position.x < -GetRadius() || transform.position.x > screenW + GetRadius() ||
+			transform.position.y < -GetRadius() || transform.position.y > screenH + GetRadius())
 			return false;
 		return true;
 	}
@@ -103,6 +1021,10 @@ public:
 		return transform.position;
 	}
 
+	Vector2 GetVelocity() const {
+		return physics.velocity;
+	}
+
 	float constexpr GetRadius() const {
 		return 16.f * (float)render.size;
 	}
@@ -116,13 +1038,7 @@ public:
 	}
 
 	int HP() const {
-		switch (render.size) {
-			case Renderable::SMALL: return 10;
-			case Renderable::MEDIUM: return 50;
-			case Renderable::LARGE: return 200;
-			case Renderable::VERYLARGE: return 500;
-			default: return 1;
-		}
+		return maxHp;
 	}
 
 	bool Damaged() const {
@@ -133,49 +1049,110 @@ public:
 		hp -= dmg;
 	}
 
+	// Queued for removal at the end of the tick; skipped by everything until then
+	bool IsRemoved() const {
+		return removed;
+	}
+
+	void MarkRemoved() {
+		removed = true;
+	}
+
+	float GetRotation() const {
+		return transform.rotation;
+	}
+
+	float GetRotationSpeed() const {
+		return physics.rotationSpeed;
+	}
+
+	int GetHP() const {
+		return hp;
+	}
+
+	uint16_t NetId() const {
+		return netId;
+	}
+
+	void SetNetId(uint16_t id) {
+		netId = id;
+	}
+
+	// Hull outline with the hp bar above it; every asteroid kind draws through this, and so do co-op replicas
+	static void DrawShape(Vector2 pos, int sides, float radius, float rotation, float hpFraction, Color bar) {
+		float x = pos.x - radius;
+		float y = pos.y - radius - 8;
+		DrawRectangle(x, y, 2 * radius, 5.0f, GRAY);
+		DrawRectangle(x, y, 2 * radius * hpFraction, 5.0f, bar);
+		Renderer::Instance().DrawPoly(pos, sides, radius, rotation);
+	}
+
+	// Exact tests against the drawn polygon; callers do the cheap bounding-circle reject first
+	bool Overlaps(Vector2 p, float r) const {
+		return Geometry::CircleOverlaps(hull, Vector2Subtract(p, transform.position), r);
+	}
+
+	bool Overlaps(float x, float yTop, float yBottom, float r) const {
+		return Geometry::VerticalSegmentOverlaps(hull, x - transform.position.x, yTop - transform.position.y, yBottom - transform.position.y, r);
+	}
+
 protected:
-	void init(int screenW, int screenH) {
+	void init(int screenW, int screenH, Utils::Rng& rng) {
 		// Choose size
 		//render.size = static_cast<Renderable::Size>(1 << GetRandomValue(0, 3));
 
 		// Spawn at random edge
-		switch (GetRandomValue(0, 3)) {
+		switch (rng.Int(0, 3)) {
 		case 0:
-			transform.position = { Utils::RandomFloat(0, screenW), -GetRadius() };
+			transform.position = { rng.Float(0, screenW), -GetRadius() };
 			break;
 		case 1:
-			transform.position = { screenW + GetRadius(), Utils::RandomFloat(0, screenH) };
+			transform.position = { screenW + GetRadius(), rng.Float(0, screenH) };
 			break;
 		case 2:
-			transform.position = { Utils::RandomFloat(0, screenW), screenH + GetRadius() };
+			transform.position = { rng.Float(0, screenW), screenH + GetRadius() };
 			break;
 		default:
-			transform.position = { -GetRadius(), Utils::RandomFloat(0, screenH) };
+			transform.position = { -GetRadius(), rng.Float(0, screenH) };
 			break;
 		}
 
 		// Aim towards center with jitter
 		float maxOff = fminf(screenW, screenH) * 0.1f;
-		float ang = Utils::RandomFloat(0, 2 * PI);
-		float rad = Utils::RandomFloat(0, maxOff);
+		float ang = rng.Float(0, 2 * PI);
+		float rad = rng.Float(0, maxOff);
 		Vector2 center = {
 										 screenW * 0.5f + cosf(ang) * rad,
 										 screenH * 0.5f + sinf(ang) * rad
 		};
 
 		Vector2 dir = Vector2Normalize(Vector2Subtract(center, transform.position));
-		physics.velocity = Vector2Scale(dir, Utils::RandomFloat(SPEED_MIN, SPEED_MAX));
-		physics.rotationSpeed = Utils::RandomFloat(ROT_MIN, ROT_MAX);
+		physics.velocity = Vector2Scale(dir, rng.Float(SPEED_MIN, SPEED_MAX));
+		physics.rotationSpeed = rng.Float(ROT_MIN, ROT_MAX);
+
+		transform.rotation = rng.Float(0, 360);
+	}
 
-		transform.rotation = Utils::RandomFloat(0, 360);
+	// size-dependent stats come from the tuning table
+	void applyTuning(const Tuning& tuning) {
+		int idx = SizeIndex(render.size);
+		baseDamage = tuning.baseDamage[idx];
+		maxHp = tuning.hp[idx];
+		hp = maxHp;
+		hull.Set(Geometry::UnitPolygonFor(sides), GetRadius(), transform.rotation);
 	}
 
 	TransformA transform;
 	Physics    physics;
 	Renderable render;
+	int        sides = 3;
+	bool       removed = false;
+	uint16_t   netId = 0;
+	Geometry::Hull hull;
 
 	int baseDamage = 0;
 	int hp;
+	int maxHp = 1;
 	static constexpr float LIFE = 10.f;
 	static constexpr float SPEED_MIN = 125.f;
 	static constexpr float SPEED_MAX = 250.f;
@@ -185,128 +1162,119 @@ protected:
 
 class TriangleAsteroid : public Asteroid {
 public:
-	TriangleAsteroid(int w, int h) : Asteroid(w, h) { 
-		baseDamage = 5;
+	TriangleAsteroid() {
 	    render.size = Renderable::SMALL;
-		hp = HP();
+		sides = 3;
 	}
 	void Draw() const override {
-		float hp_bar_width = 2 * GetRadius() * (float(hp) /HP());
-		float initial_width = 2 * GetRadius();
-		float hp_bar_height = 5.0f;
-    	float x = transform.position.x - GetRadius();
-    	float y = transform.position.y - GetRadius() - 8;
-		DrawRectangle(x, y, initial_width, hp_bar_height, GRAY);  // Background bar
-    	DrawRectangle(x, y, hp_bar_width, hp_bar_height, WHITE);  // Filled bar
-		Renderer::Instance().DrawPoly(transform.position, 3, GetRadius(), transform.rotation);
+		DrawShape(transform.position, sides, GetRadius(), transform.rotation, float(hp) / HP(), WHITE);
 	}
 };
 class SquareAsteroid : public Asteroid {
 public:
-	SquareAsteroid(int w, int h) : Asteroid(w, h) {
-		baseDamage = 10; 
+	SquareAsteroid() {
 		render.size = Renderable::MEDIUM;
-		hp = HP();}
+		sides = 4;}
 	void Draw() const override {
-		float hp_bar_width = 2 * GetRadius() * (float(hp) /HP());
-		float initial_width = 2 * GetRadius();
-		float hp_bar_height = 5.0f;
-    	float x = transform.position.x - GetRadius();
-    	float y = transform.position.y - GetRadius() - 8;
-		DrawRectangle(x, y, initial_width, hp_bar_height, GRAY);  // Background bar
-    	DrawRectangle(x, y, hp_bar_width, hp_bar_height, BLUE);  // Filled bar
-		Renderer::Instance().DrawPoly(transform.position, 4, GetRadius(), transform.rotation);
+		DrawShape(transform.position, sides, GetRadius(), transform.rotation, float(hp) / HP(), BLUE);
 	}
 };
 class PentagonAsteroid : public Asteroid {
 public:
-	PentagonAsteroid(int w, int h) : Asteroid(w, h) {
-		baseDamage = 15; 
+	PentagonAsteroid() {
 		render.size = Renderable::LARGE;
-		hp = HP();}
+		sides = 5;}
 	void Draw() const override {
-		float hp_bar_width = 2 * GetRadius() * (float(hp) /HP());
-		float initial_width = 2 * GetRadius();
-		float hp_bar_height = 5.0f;
-    	float x = transform.position.x - GetRadius();
-    	float y = transform.position.y - GetRadius() - 8;
-		DrawRectangle(x, y, initial_width, hp_bar_height, GRAY);  // Background bar
-    	DrawRectangle(x, y, hp_bar_width, hp_bar_height, PURPLE);  // Filled bar
-		Renderer::Instance().DrawPoly(transform.position, 5, GetRadius(), transform.rotation);
+		DrawShape(transform.position, sides, GetRadius(), transform.rotation, float(hp) / HP(), PURPLE);
 	}
 };
 class VeryLargeAsteroid : public Asteroid {
 public:
-	VeryLargeAsteroid(int w, int h) : Asteroid(w, h) {
-		baseDamage = 10; 
+	VeryLargeAsteroid() {
 		render.size = Renderable::VERYLARGE;
-		hp = HP();}
+		sides = 8;}
 	void Draw() const override {
-		float hp_bar_width = 2 * GetRadius() * (float(hp) /HP());
-		float initial_width = 2 * GetRadius();
-		float hp_bar_height = 5.0f;
-    	float x = transform.position.x - GetRadius();
-    	float y = transform.position.y - GetRadius() - 8;
-		DrawRectangle(x, y, initial_width, hp_bar_height, GRAY);  // Background bar
-    	DrawRectangle(x, y, hp_bar_width, hp_bar_height, MAGENTA);  // Filled bar
-		Renderer::Instance().DrawPoly(transform.position, 8, GetRadius(), transform.rotation);
+		DrawShape(transform.position, sides, GetRadius(), transform.rotation, float(hp) / HP(), MAGENTA);
 	}
 };
 
 // Shape selector
 enum class AsteroidShape { TRIANGLE = 3, SQUARE = 4, PENTAGON = 5, VERYLARGE = 6, RANDOM = 0 };
 
-// Factory
-static inline std::unique_ptr<Asteroid> MakeAsteroid(int w, int h, AsteroidShape shape) {
+// Blank asteroid for a size index (SizeIndex order: triangle, square, pentagon, very large); Spawn* places it
+static inline std::unique_ptr<Asteroid> NewAsteroid(int sizeIndex) {
+	switch (sizeIndex) {
+	case 0:
+		return std::make_unique<TriangleAsteroid>();
+	case 1:
+		return std::make_unique<SquareAsteroid>();
+	case 2:
+		return std::make_unique<PentagonAsteroid>();
+	default:
+		return std::make_unique<VeryLargeAsteroid>();
+	}
+}
+
+// Resolves the selector (RANDOM uses the tuning spawn mix) to a size index
+static inline int PickShape(AsteroidShape shape, Utils::Rng& rng, const Tuning& tuning) {
 	switch (shape) {
 	case AsteroidShape::TRIANGLE:
-		return std::make_unique<TriangleAsteroid>(w, h);
+		return 0;
 	case AsteroidShape::SQUARE:
-		return std::make_unique<SquareAsteroid>(w, h);
+		return 1;
 	case AsteroidShape::PENTAGON:
-		return std::make_unique<PentagonAsteroid>(w, h);
+		return 2;
 	case AsteroidShape::VERYLARGE:
-		return std::make_unique<VeryLargeAsteroid>(w, h);
+		return 3;
 	default: {
-		int Shape = GetRandomValue(0, 99);
-		if (Shape < 40) {
-			return MakeAsteroid(w, h, AsteroidShape::TRIANGLE);
+		const int* weights = tuning.spawnWeights;
+		int total = weights[0] + weights[1] + weights[2] + weights[3];
+		int Shape = rng.Int(0, std::max(total, 1) - 1);
+		if (Shape < weights[0]) {
+			return 0;
 		}
-		else if (Shape < 65) {
-			return MakeAsteroid(w, h, AsteroidShape::SQUARE);
+		else if (Shape < weights[0] + weights[1]) {
+			return 1;
 		}
-		else if (Shape < 85) {
-			return MakeAsteroid(w, h, AsteroidShape::PENTAGON);
+		else if (Shape < weights[0] + weights[1] + weights[2]) {
+			return 2;
 		}
 		else {
-			return MakeAsteroid(w, h, AsteroidShape::VERYLARGE);
+			return 3;
 		}
 	}
 	}
 }
 
+// Factory
+static inline std::unique_ptr<Asteroid> MakeAsteroid(int w, int h, AsteroidShape shape, Utils::Rng& rng, const Tuning& tuning) {
+	auto asteroid = NewAsteroid(PickShape(shape, rng, tuning));
+	asteroid->SpawnAtEdge(w, h, rng, tuning);
+	return asteroid;
+}
+
 class Bonus {
 public:
-    Bonus(int screenW, int screenH) {
-    float angle = Utils::RandomFloat(50.f, 100.f);
-	float speed = Utils::RandomFloat(100.f, 200.f);
-
-    switch (GetRandomValue(0, 3)) {
-    case 0: 
-        position = { Utils::RandomFloat(0, screenW), -radius };
-        angle = Utils::RandomFloat(PI / 6, 5 * PI / 6); 
+    Bonus(int screenW, int screenH, Utils::Rng& rng) {
+    float angle = rng.Float(50.f, 100.f);
+	float speed = rng.Float(100.f, 200.f);
+
+    switch (rng.Int(0, 3)) {
+    case 0:
+        position = { rng.Float(0, screenW), -radius };
+        angle = rng.Float(PI / 6, 5 * PI / 6);
         break;
-    case 1: 
-        position = { screenW + radius, Utils::RandomFloat(0, screenH) };
-        angle = Utils::RandomFloat(2 * PI / 3, 4 * PI / 3); 
+    case 1:
+        position = { screenW + radius, rng.Float(0, screenH) };
+        angle = rng.Float(2 * PI / 3, 4 * PI / 3);
         break;
-    case 2: 
-        position = { Utils::RandomFloat(0, screenW), screenH + radius };
-        angle = Utils::RandomFloat(7 * PI / 6, 11 * PI / 6); 
+    case 2:
+        position = { rng.Float(0, screenW), screenH + radius };
+        angle = rng.Float(7 * PI / 6, 11 * PI / 6);
         break;
-    default: 
-        position = { -radius, Utils::RandomFloat(0, screenH) };
-        angle = Utils::RandomFloat(-PI / 3, PI / 3); 
+    default:
+        position = { -radius, rng.Float(0, screenH) };
+        angle = rng.Float(-PI / 3, PI / 3);
         break;
     }
 
@@ -328,84 +1296,194 @@ public:
     }
 
     Vector2 GetPosition() const { return position; }
+    Vector2 GetVelocity() const { return velocity; }
     float GetRadius() const { return radius; }
+    uint16_t NetId() const { return netId; }
+    void SetNetId(uint16_t id) { netId = id; }
 
 private:
     Vector2 position;
     Vector2 velocity;
     float radius = 25.f;
+    uint16_t netId = 0;
 };
 
 
 
-// --- PROJECTILE HIERARCHY ---
-enum class WeaponType { LASER, BULLET, COUNT };
-class Projectile {
-public:
-	Projectile(Vector2 pos, Vector2 vel, int dmg, WeaponType wt)
-	{
-		transform.position = pos;
-		physics.velocity = vel;
-		baseDamage = dmg;
-		type = wt;
+// --- PROJECTILES ---
+// Plain data; the behaviour is in the per-kind kernels of World
+struct Projectile {
+	Vector2         position;
+	Vector2         velocity;
+	int             damage;
+	int             hitsLeft;     // asteroids it can still pass through
+	uint16_t        netId;
+	uint8_t         owner;        // pilot index, credited with hits and kills
+	uint8_t         hitCount;
+	uint16_t        hitIds[MAX_PIERCE + 1];    // netIds already passed through; each asteroid is hit once
+};
+
+// Bounding circle reject first, then the exact test against the drawn polygon. HULL = false is the
+// circle-only baseline that --collision-bench measures the polygon test against
+template <ProjectileKind K, bool HULL = true>
+inline static bool ProjectileOverlaps(Vector2 position, const Asteroid& asteroid) {
+	using Traits = ProjectileTraits<K>;
+	float reach = Traits::RADIUS + asteroid.GetRadius();
+	float yTop = position.y - Traits::LENGTH;
+	float distSqr;
+	if constexpr (Traits::LENGTH > 0.f) {
+		distSqr = Geometry::VerticalSegmentDistanceSqr(position.x, yTop, position.y, asteroid.GetPosition());
 	}
-	bool Update(float dt) {
-		transform.position = Vector2Add(transform.position, Vector2Scale(physics.velocity, dt));
-		if (transform.position.x < 0 ||
-			transform.position.x > Renderer::Instance().Width() ||
-			transform.position.y < 0 ||
-			transform.position.y > Renderer::Instance().Height())
-		{
-			return true;
-		}
-		return false;
+	else {
+		distSqr = Vector2DistanceSqr(position, asteroid.GetPosition());
 	}
-	void Draw() const {
-		if (type == WeaponType::BULLET) {
-			DrawCircleV(transform.position, 5.f, WHITE);
-		}
-		else {
-			static constexpr float LASER_LENGTH = 30.f;
-			Rectangle lr = { transform.position.x - 2.f, transform.position.y - LASER_LENGTH, 4.f, LASER_LENGTH };
-			DrawRectangleRec(lr, RED);
-		}
+	if (distSqr >= reach * reach) [[likely]] return false;
+	if constexpr (!HULL) {
+		return true;
 	}
-	Vector2 GetPosition() const {
-		return transform.position;
+	else if constexpr (Traits::LENGTH > 0.f) {
+		return asteroid.Overlaps(position.x, yTop, position.y, Traits::RADIUS);
 	}
-
-	float GetRadius() const {
-		return (type == WeaponType::BULLET) ? 5.f : 2.f;
+	else {
+		return asteroid.Overlaps(position, Traits::RADIUS);
 	}
+}
 
-	int GetDamage() const {
-		return baseDamage;
+template <ProjectileKind K>
+static void DrawProjectile(Vector2 position, Vector2 velocity) {
+	if constexpr (K == ProjectileKind::BULLET) {
+		DrawCircleV(position, ProjectileTraits<K>::RADIUS, WHITE);
 	}
-
-private:
-	TransformA transform;
-	Physics    physics;
-	int        baseDamage;
-	WeaponType type;
-};
-
-inline static Projectile MakeProjectile(WeaponType wt,
-	const Vector2 pos,
-	float speed)
-{
-	Vector2 vel{ 0, -speed };
-	if (wt == WeaponType::LASER) {
-		return Projectile(pos, vel, 20, wt);
+	else if constexpr (K == ProjectileKind::LASER) {
+		static constexpr float LASER_LENGTH = ProjectileTraits<K>::LENGTH;
+		Rectangle lr = { position.x - 2.f, position.y - LASER_LENGTH, 4.f, LASER_LENGTH };
+		DrawRectangleRec(lr, RED);
+	}
+	else if constexpr (K == ProjectileKind::BEAM) {
+		static constexpr float BEAM_LENGTH = ProjectileTraits<K>::LENGTH;
+		Rectangle br = { position.x - 3.f, position.y - BEAM_LENGTH, 6.f, BEAM_LENGTH };
+		DrawRectangleRec(br, SKYBLUE);
 	}
 	else {
-		return Projectile(pos, vel, 10, wt);
+		Vector2 tail = Vector2Subtract(position, Vector2Scale(Vector2Normalize(velocity), 12.f));
+		DrawLineEx(tail, position, 2.f, GRAY);
+		DrawCircleV(position, ProjectileTraits<K>::RADIUS, ORANGE);
 	}
 }
 
-// --- SHIP HIERARCHY ---
-class Ship {
+// The light a projectile casts, centred on what DrawProjectile draws. emit(position, radius, color)
+template <ProjectileKind K, typename Emit>
+static void EmitProjectileLight(Vector2 position, Emit&& emit) {
+	emit(Vector2{ position.x, position.y - ProjectileTraits<K>::LENGTH * 0.5f }, ProjectileTraits<K>::LIGHT_RADIUS, ProjectileTraits<K>::LIGHT_COLOR);
+}
+
+static constexpr float BONUS_LIGHT_RADIUS = 120.f;
+
+// Uniform grid over asteroid centers, rebuilt once per tick, for nearest-asteroid queries (homing)
+class AsteroidIndex {
 public:
-	Ship(int screenW, int screenH) {
+	void Reserve(size_t asteroids, int screenW, int screenH) {
+		points.reserve(asteroids);
+		cellOf.reserve(asteroids);
+		cellStart.reserve(static_cast<size_t>((screenW / static_cast<int>(CELL) + 1) * (screenH / static_cast<int>(CELL) + 1) + 1));
+		fill.reserve(cellStart.capacity());
+	}
+
+	void Build(const std::vector<std::unique_ptr<Asteroid>>& asteroids, int screenW, int screenH) {
+		cols = screenW / static_cast<int>(CELL) + 1;
+		rows = screenH / static_cast<int>(CELL) + 1;
+		cellStart.assign(static_cast<size_t>(cols * rows + 1), 0);
+		points.resize(asteroids.size());
+		cellOf.resize(asteroids.size());
+
+		// counting sort by cell
+		minX = cols;
+		minY = rows;
+		maxX = -1;
+		maxY = -1;
+		for (size_t i = 0; i < asteroids.size(); ++i) {
+			cellOf[i] = cellIndex(asteroids[i]->GetPosition());
+			++cellStart[static_cast<size_t>(cellOf[i]) + 1];
+			minX = std::min(minX, cellOf[i] % cols);
+			maxX = std::max(maxX, cellOf[i] % cols);
+			minY = std::min(minY, cellOf[i] / cols);
+			maxY = std::max(maxY, cellOf[i] / cols);
+		}
+		for (size_t c = 1; c < cellStart.size(); ++c) {
+			cellStart[c] += cellStart[c - 1];
+		}
+		fill.assign(cellStart.begin(), cellStart.end() - 1);
+		for (size_t i = 0; i < asteroids.size(); ++i) {
+			points[static_cast<size_t>(fill[static_cast<size_t>(cellOf[i])]++)] = asteroids[i]->GetPosition();
+		}
+	}
+
+	// Nearest asteroid center within maxDist of p. Scans rings of cells outwards and stops as soon
+	// as no unvisited ring can hold anything closer than the best hit
+	bool Nearest(Vector2 p, float maxDist, Vector2& out) const {
+		if (points.empty()) return false;
+		int cx = std::clamp(static_cast<int>(p.x / CELL), 0, cols - 1);
+		int cy = std::clamp(static_cast<int>(p.y / CELL), 0, rows - 1);
+		// rings past the occupied cells cannot hold anything
+		int maxRing = std::min(static_cast<int>(maxDist / CELL) + 1,
+			std::max({ cx - minX, maxX - cx, cy - minY, maxY - cy }));
+		float best = maxDist * maxDist;
+		bool found = false;
+
+		for (int ring = 0; ring <= maxRing; ++ring) {
+			for (int y = cy - ring; y <= cy + ring; ++y) {
+				if (y < minY || y > maxY) continue;
+				bool edgeRow = (y == cy - ring || y == cy + ring);
+				for (int x = cx - ring; x <= cx + ring; x += edgeRow ? 1 : 2 * ring) {
+					if (x < minX || x > maxX) continue;
+					int cell = y * cols + x;
+					for (int i = cellStart[static_cast<size_t>(cell)]; i < cellStart[static_cast<size_t>(cell) + 1]; ++i) {
+						float d = Vector2DistanceSqr(p, points[static_cast<size_t>(i)]);
+						if (d < best) {
+							best = d;
+							out = points[static_cast<size_t>(i)];
+							found = true;
+						}
+					}
+				}
+			}
+			float reach = ring * CELL;
+			if (found && best <= reach * reach) break;
+		}
+		return found;
+	}
+
+private:
+	int cellIndex(Vector2 p) const {
+		int x = std::clamp(static_cast<int>(p.x / CELL), 0, cols - 1);
+		int y = std::clamp(static_cast<int>(p.y / CELL), 0, rows - 1);
+		return y * cols + x;
+	}
+
+	static constexpr float CELL = 128.f;
+	int cols = 1;
+	int rows = 1;
+	int minX = 0, minY = 0, maxX = -1, maxY = -1;    // bounding box of occupied cells
+	std::vector<int>     cellStart;
+	std::vector<int>     fill;
+	std::vector<int>     cellOf;
+	std::vector<Vector2> points;
+};
+
+// --- SHIP HIERARCHY ---
+// One frame of ship controls. Sampled from the keyboard in the game, produced by a bot in batch runs
+struct ShipInput {
+	bool up = false;
+	bool down = false;
+	bool left = false;
+	bool right = false;
+	bool fire = false;
+	WeaponType weapon = WeaponType::LASER;
+};
+
+class Ship {
+public:
+	Ship(int screenW, int screenH) {
 		transform.position = {
 												 screenW * 0.5f,
 												 screenH * 0.5f
@@ -413,17 +1491,22 @@ public:
 		hp = 100;
 		speed = 250.f;
 		alive = true;
-
-		// per-weapon fire rate & spacing
-		fireRateLaser = 18.f; // shots/sec
-		fireRateBullet = 22.f;
-		spacingLaser = 40.f; // px between lasers
-		spacingBullet = 20.f;
 	}
 	virtual ~Ship() = default;
-	virtual void Update(float dt) = 0;
 	virtual void Draw() const = 0;
 
+	void Update(float dt, const ShipInput& input) {
+		if (alive) {
+			if (input.up) transform.position.y -= speed * dt;
+			if (input.down) transform.position.y += speed * dt;
+			if (input.left) transform.position.x -= speed * dt;
+			if (input.right) transform.position.x += speed * dt;
+		}
+		else {
+			transform.position.y += speed * dt;
+		}
+	}
+
 	void TakeDamage(int dmg) {
 		if (!alive) return;
 		hp -= dmg;
@@ -447,12 +1530,11 @@ public:
 		else return 0;
 	}
 
-	float GetFireRate(WeaponType wt) const {
-		return (wt == WeaponType::LASER) ? fireRateLaser : fireRateBullet;
-	}
-
-	float GetSpacing(WeaponType wt) const {
-		return (wt == WeaponType::LASER) ? spacingLaser : spacingBullet;
+	// Overwrites the simulated state, e.g. with the server's copy on a co-op client
+	void SetState(Vector2 position, int hitPoints, bool isAlive) {
+		transform.position = position;
+		hp = hitPoints;
+		alive = isAlive;
 	}
 
 protected:
@@ -460,35 +1542,14 @@ protected:
 	int        hp;
 	float      speed;
 	bool       alive;
-	float      fireRateLaser;
-	float      fireRateBullet;
-	float      spacingLaser;
-	float      spacingBullet;
 };
 
 class PlayerShip :public Ship {
 public:
-	PlayerShip(int w, int h) : Ship(w, h) {
-		texture = LoadTexture("dog.png");
-		GenTextureMipmaps(&texture);                                                        // Generate GPU mipmaps for a texture
-		SetTextureFilter(texture, 2);
+	// texture is owned by the Application and shared across restarts
+	PlayerShip(int w, int h, Texture2D shared) : Ship(w, h), texture(shared) {
 		scale = 0.05f;
 	}
-	~PlayerShip() {
-		UnloadTexture(texture);
-	}
-
-	void Update(float dt) override {
-		if (alive) {
-			if (IsKeyDown(KEY_W)) transform.position.y -= speed * dt;
-			if (IsKeyDown(KEY_S)) transform.position.y += speed * dt;
-			if (IsKeyDown(KEY_A)) transform.position.x -= speed * dt;
-			if (IsKeyDown(KEY_D)) transform.position.x += speed * dt;
-		}
-		else {
-			transform.position.y += speed * dt;
-		}
-	}
 
 	void Draw() const override {
 		if (!alive && fmodf(GetTime(), 0.4f) > 0.2f) return;
@@ -508,244 +1569,3497 @@ private:
 	float     scale;
 };
 
-// --- APPLICATION ---
-class Application {
+// Ship without a texture or window, used by the batch runner
+class HeadlessShip :public Ship {
 public:
-	static Application& Instance() {
-		static Application inst;
-		return inst;
+	HeadlessShip(int w, int h) : Ship(w, h) {}
+
+	void Draw() const override {}
+
+	float GetRadius() const override {
+		return RADIUS;
 	}
-	void Run() {
-		srand(static_cast<unsigned>(time(nullptr)));
-		Renderer::Instance().Init(C_WIDTH, C_HEIGHT, "Asteroids OOP");
 
-		auto player = std::make_unique<PlayerShip>(C_WIDTH, C_HEIGHT);
+private:
+	static constexpr float RADIUS = 24.f;
+};
+
+// --- GAMEPLAY EVENTS ---
+// What happened during a tick, as plain records. Systems append while the World ticks (one thread
+// per World, so nothing is locked); at the end of the tick scoring consumes them, and whoever owns the
+// World can hand the same batch to a TelemetryWriter
+namespace Events {
+	enum class Type : uint8_t { KILL, HIT, DAMAGE, PICKUP, SPAWN, WEAPON_SWITCH, MATCH_START, COUNT };
+	static constexpr size_t TYPE_COUNT = static_cast<size_t>(Type::COUNT);
+	static constexpr const char* TYPE_NAMES[TYPE_COUNT] = { "kill", "hit", "damage", "pickup", "spawn", "weapon", "match" };
 
-		float spawnTimer = 0.f;
-		float spawnInterval = Utils::RandomFloat(C_SPAWN_MIN, C_SPAWN_MAX);
-		WeaponType currentWeapon = WeaponType::LASER;
-		float shotTimer = 0.f;
+	enum SpawnSource : uint8_t { SPAWN_EDGE, SPAWN_FRAGMENT, SPAWN_BONUS, SPAWN_SOURCE_COUNT };
+	static constexpr uint8_t NO_PLAYER = 0x0F;
 
-		while (!WindowShouldClose()) {
-			float dt = GetFrameTime();
-			spawnTimer += dt;
+	// Score per destroyed asteroid, by size index
+	static constexpr int KILL_POINTS[4] = { 2, 4, 8, 10 };
 
-			// Update player
-			player->Update(dt);
+	// Fields by type:
+	//   KILL, HIT      player = shooter, size = asteroid size index, kind = ProjectileKind, entity = asteroid,
+	//                  amount = damage dealt (HIT)
+	//   DAMAGE         player rammed, size = asteroid size index, amount = damage taken
+	//   PICKUP         player, entity = bonus, amount = hp restored
+	//   SPAWN          size = asteroid size index, kind = SpawnSource, entity = new asteroid or bonus
+	//   WEAPON_SWITCH  player, kind = WeaponType
+	//   MATCH_START    first event of every World, at time 0; amount = players. World time restarts here
+	struct Event {
+		uint32_t timeMs;     // world time
+		Type     type;
+		uint8_t  player;
+		uint8_t  size;
+		uint8_t  kind;
+		uint16_t entity;
+		int16_t  amount;
+		int16_t  x;
+		int16_t  y;
+	};
+	static_assert(sizeof(Event) == 16, "events are copied around in bulk");
 
-			// Restart logic
-			if (!player->IsAlive() && IsKeyPressed(KEY_R)) {
-				player = std::make_unique<PlayerShip>(C_WIDTH, C_HEIGHT);
-				asteroids.clear();
-				projectiles.clear();
-				spawnTimer = 0.f;
-				spawnInterval = Utils::RandomFloat(C_SPAWN_MIN, C_SPAWN_MAX);
+	static Event Make(Type type, float time, Vector2 position, uint8_t player = NO_PLAYER) {
+		Event e{};
+		e.timeMs = static_cast<uint32_t>(time * 1000.f);
+		e.type = type;
+		e.player = player;
+		e.x = static_cast<int16_t>(Clamp(position.x, -32768.f, 32767.f));
+		e.y = static_cast<int16_t>(Clamp(position.y, -32768.f, 32767.f));
+		return e;
+	}
+
+	// Events that change the match (scoring consumes KILL and PICKUP, a replay splits on MATCH_START);
+	// the rest are only there for telemetry
+	static constexpr bool IsGameplay(Type type) {
+		return type == Type::KILL || type == Type::PICKUP || type == Type::MATCH_START;
+	}
+
+	// One tick's events, with a fixed capacity so a tick never allocates. Gameplay events get room for
+	// the owner's per-tick bound on top and are never dropped; telemetry-only ones past CAPACITY are
+	// dropped and counted (TelemetryWriter reports them with its own drops)
+	class Buffer {
+	public:
+		static constexpr size_t CAPACITY = 4096;    // telemetry-only events per tick
+
+		explicit Buffer(size_t gameplayBound) { events.reserve(CAPACITY + gameplayBound); }
+
+		void Push(const Event& e) {
+			if (IsGameplay(e.type)) {
+				events.push_back(e);
 			}
-			// Asteroid shape switch
-			if (IsKeyPressed(KEY_ONE)) {
-				currentShape = AsteroidShape::TRIANGLE;
+			else if (observed < CAPACITY) {
+				events.push_back(e);
+				++observed;
 			}
-			if (IsKeyPressed(KEY_TWO)) {
-				currentShape = AsteroidShape::SQUARE;
+			else {
+				++dropped;
 			}
-			if (IsKeyPressed(KEY_THREE)) {
-				currentShape = AsteroidShape::PENTAGON;
+		}
+		void Clear() {
+			events.clear();
+			observed = 0;
+			dropped = 0;
+		}
+
+		const Event* Data() const { return events.data(); }
+		size_t Size() const { return events.size(); }
+		const Event* begin() const { return events.data(); }
+		const Event* end() const { return events.data() + events.size(); }
+		uint64_t Dropped() const { return dropped; }    // this tick, telemetry-only events
+
+	private:
+		std::vector<Event> events;
+		size_t   observed = 0;    // telemetry-only events this tick
+		uint64_t dropped = 0;
+	};
+
+	// Aggregate stats; built live or by replaying a telemetry file, both through Add
+	struct Totals {
+		static constexpr size_t PLAYERS = 4;
+
+		uint64_t count[TYPE_COUNT] = {};
+		int      matches = 0;
+		uint64_t durationMs = 0;    // finished matches
+		uint32_t matchMs = 0;       // the current one, up to its latest event
+		int      score = 0;
+		int      kills = 0;
+		int      killsBySize[4] = {};
+		int      killsByKind[PROJECTILE_KIND_COUNT] = {};
+		int      hitsByKind[PROJECTILE_KIND_COUNT] = {};
+		int64_t  damageByKind[PROJECTILE_KIND_COUNT] = {};
+		int      spawns[SPAWN_SOURCE_COUNT] = {};
+		struct Player {
+			int kills = 0;
+			int score = 0;
+			int damageTaken = 0;
+			int healed = 0;
+			int pickups = 0;
+			int switches = 0;
+		} players[PLAYERS];
+
+		void Add(const Event& e) {
+			count[static_cast<size_t>(e.type)]++;
+			if (e.type == Type::MATCH_START) {
+				++matches;
+				durationMs += matchMs;
+				matchMs = 0;
 			}
-			if (IsKeyPressed(KEY_FOUR)) {
-				currentShape = AsteroidShape::RANDOM;
+			matchMs = std::max(matchMs, e.timeMs);
+			Player* p = e.player < PLAYERS ? &players[e.player] : nullptr;
+			switch (e.type) {
+			case Type::KILL:
+				++kills;
+				score += KILL_POINTS[e.size & 3];
+				killsBySize[e.size & 3]++;
+				if (e.kind < PROJECTILE_KIND_COUNT) killsByKind[e.kind]++;
+				if (p) {
+					++p->kills;
+					p->score += KILL_POINTS[e.size & 3];
+				}
+				break;
+			case Type::HIT:
+				if (e.kind < PROJECTILE_KIND_COUNT) {
+					hitsByKind[e.kind]++;
+					damageByKind[e.kind] += e.amount;
+				}
+				break;
+			case Type::DAMAGE:
+				if (p) p->damageTaken += e.amount;
+				break;
+			case Type::PICKUP:
+				if (p) {
+					++p->pickups;
+					p->healed += e.amount;
+				}
+				break;
+			case Type::SPAWN:
+				if (e.kind < SPAWN_SOURCE_COUNT) spawns[e.kind]++;
+				break;
+			case Type::WEAPON_SWITCH:
+				if (p) ++p->switches;
+				break;
+			default:
+				break;
 			}
-			if (IsKeyPressed(KEY_FIVE)) {
-				currentShape = AsteroidShape::VERYLARGE;
+		}
+
+		double Duration() const { return (durationMs + matchMs) / 1000.0; }    // seconds, all matches
+
+		void Print() const {
+			static constexpr const char* KINDS[PROJECTILE_KIND_COUNT] = { "laser", "bullet", "beam", "missile" };
+			uint64_t all = 0;
+			for (uint64_t c : count) all += c;
+			printf("%d matches, %llu events over %.1f s:", matches, static_cast<unsigned long long>(all), Duration());
+			for (size_t t = 0; t < TYPE_COUNT; ++t) {
+				printf(" %s %llu", TYPE_NAMES[t], static_cast<unsigned long long>(count[t]));
+			}
+			printf("\nscore %d, kills %d (by size %d/%d/%d/%d)\n", score, kills, killsBySize[0], killsBySize[1], killsBySize[2], killsBySize[3]);
+			for (int k = 0; k < PROJECTILE_KIND_COUNT; ++k) {
+				if (!hitsByKind[k]) continue;
+				printf("  %-8s %7d hits %9lld damage %6d kills\n", KINDS[k], hitsByKind[k], static_cast<long long>(damageByKind[k]), killsByKind[k]);
 			}
+			printf("spawns: %d edge, %d fragment, %d bonus\n", spawns[SPAWN_EDGE], spawns[SPAWN_FRAGMENT], spawns[SPAWN_BONUS]);
+			for (size_t i = 0; i < PLAYERS; ++i) {
+				const Player& p = players[i];
+				if (!p.kills && !p.damageTaken && !p.pickups && !p.switches) continue;
+				printf("player %zu: %d kills, %d score, %d damage taken, %d healed from %d pickups, %d weapon switches\n",
+					i, p.kills, p.score, p.damageTaken, p.healed, p.pickups, p.switches);
+			}
+		}
+	};
 
-			// Weapon switch
-			if (IsKeyPressed(KEY_TAB)) {
-				currentWeapon = static_cast<WeaponType>((static_cast<int>(currentWeapon) + 1) % static_cast<int>(WeaponType::COUNT));
+	// Streams events to disk from a background thread. Submit copies into a single-producer ring and never
+	// waits: if the writer falls behind the ring fills up and the overflow is counted, not blocked on.
+	// On disk: "AEV2", then per event a varint ms delta from the previous event (from 0 for MATCH_START),
+	// type|player and size|kind nibbles, and zigzag varints for entity, amount, x and y
+	class TelemetryWriter {
+	public:
+		static constexpr size_t RING = 1 << 16;    // events, power of two
+		static constexpr char MAGIC[4] = { 'A', 'E', 'V', '2' };
+
+		~TelemetryWriter() { Close(); }
+
+		bool Open(const char* path) {
+			Close();
+			file.open(path, std::ios::binary | std::ios::trunc);
+			if (!file) return false;
+			file.write(MAGIC, sizeof(MAGIC));
+			ring.resize(RING);
+			encoded.reserve(FLUSH_BYTES + 64);
+			head.store(0);
+			tail.store(0);
+			lastMs = 0;
+			running.store(true);
+			worker = std::thread([this] { run(); });
+			return true;
+		}
+
+		void Submit(const Event* events, size_t count) {
+			if (!running.load(std::memory_order_relaxed)) return;
+			size_t h = head.load(std::memory_order_relaxed);
+			size_t room = RING - (h - tail.load(std::memory_order_acquire));
+			size_t n = std::min(count, room);
+			for (size_t i = 0; i < n; ++i) {
+				ring[(h + i) & (RING - 1)] = events[i];
 			}
+			head.store(h + n, std::memory_order_release);
+			dropped.fetch_add(count - n, std::memory_order_relaxed);
+		}
+		void Submit(const Buffer& buffer) {
+			Submit(buffer.Data(), buffer.Size());
+			if (running.load(std::memory_order_relaxed)) dropped.fetch_add(buffer.Dropped(), std::memory_order_relaxed);
+		}
 
-			// Shooting
-			{
-				if (player->IsAlive() && IsKeyDown(KEY_SPACE)) {
-					shotTimer += dt;
-					float interval = 1.f / player->GetFireRate(currentWeapon);
-					float projSpeed = player->GetSpacing(currentWeapon) * player->GetFireRate(currentWeapon);
-
-					while (shotTimer >= interval) {
-						Vector2 p = player->GetPosition();
-						p.y -= player->GetRadius();
-						projectiles.push_back(MakeProjectile(currentWeapon, p, projSpeed));
-						shotTimer -= interval;
-					}
+		// Drains what was submitted and closes the file
+		void Close() {
+			if (!worker.joinable()) return;
+			running.store(false);
+			worker.join();
+			file.close();
+		}
+
+		bool IsOpen() const { return worker.joinable(); }
+		uint64_t Written() const { return written.load(std::memory_order_relaxed); }
+		uint64_t Dropped() const { return dropped.load(std::memory_order_relaxed); }
+		uint64_t Bytes() const { return bytes.load(std::memory_order_relaxed); }
+
+	private:
+		static constexpr size_t FLUSH_BYTES = 64 * 1024;
+
+		void run() {
+			for (;;) {
+				bool stopping = !running.load(std::memory_order_acquire);
+				size_t t = tail.load(std::memory_order_relaxed);
+				size_t h = head.load(std::memory_order_acquire);
+				for (; t != h; ++t) {
+					encode(ring[t & (RING - 1)]);
+					if (encoded.size() >= FLUSH_BYTES) flush();
 				}
-				else {
-					float maxInterval = 1.f / player->GetFireRate(currentWeapon);
+				tail.store(t, std::memory_order_release);
+				if (stopping) break;
+				std::this_thread::sleep_for(std::chrono::milliseconds(5));
+			}
+			flush();
+		}
 
-					if (shotTimer > maxInterval) {
-						shotTimer = fmodf(shotTimer, maxInterval);
-					}
+		void encode(const Event& e) {
+			if (e.type == Type::MATCH_START) lastMs = 0;    // a new World's clock starts over
+			putVarint(e.timeMs - std::min(e.timeMs, lastMs));
+			lastMs = std::max(lastMs, e.timeMs);
+			encoded.push_back(static_cast<uint8_t>(static_cast<uint8_t>(e.type) | (std::min<uint8_t>(e.player, NO_PLAYER) << 4)));
+			encoded.push_back(static_cast<uint8_t>((e.size & 0x0F) | (e.kind << 4)));
+			putVarint(e.entity);
+			putVarint(Zigzag(e.amount));
+			putVarint(Zigzag(e.x));
+			putVarint(Zigzag(e.y));
+			written.fetch_add(1, std::memory_order_relaxed);
+		}
+
+		void putVarint(uint32_t v) {
+			while (v >= 0x80) {
+				encoded.push_back(static_cast<uint8_t>(v | 0x80));
+				v >>= 7;
+			}
+			encoded.push_back(static_cast<uint8_t>(v));
+		}
+
+		void flush() {
+			if (encoded.empty()) return;
+			file.write(reinterpret_cast<const char*>(encoded.data()), static_cast<std::streamsize>(encoded.size()));
+			bytes.fetch_add(encoded.size(), std::memory_order_relaxed);
+			encoded.clear();
+		}
+
+		static uint32_t Zigzag(int32_t v) { return (static_cast<uint32_t>(v) << 1) ^ static_cast<uint32_t>(v >> 31); }
+
+		std::ofstream        file;
+		std::vector<Event>   ring;
+		std::vector<uint8_t> encoded;
+		uint32_t             lastMs = 0;
+		std::thread          worker;
+		std::atomic<bool>    running{ false };
+		std::atomic<size_t>  head{ 0 };    // written by Submit
+		std::atomic<size_t>  tail{ 0 };    // written by the worker
+		std::atomic<uint64_t> written{ 0 };
+		std::atomic<uint64_t> dropped{ 0 };
+		std::atomic<uint64_t> bytes{ 0 };
+	};
+
+	// Decodes a TelemetryWriter file, calling fn(event) in order; false if the file is not telemetry
+	// or ends mid-event
+	template <typename Fn>
+	static bool ReadTelemetry(const char* path, Fn&& fn) {
+		std::ifstream in(path, std::ios::binary);
+		if (!in) return false;
+		std::vector<uint8_t> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+		if (data.size() < sizeof(TelemetryWriter::MAGIC) || memcmp(data.data(), TelemetryWriter::MAGIC, sizeof(TelemetryWriter::MAGIC))) return false;
+
+		size_t at = sizeof(TelemetryWriter::MAGIC);
+		bool ok = true;
+		auto varint = [&]() {
+			uint32_t v = 0;
+			for (int shift = 0; shift < 35; shift += 7) {
+				if (at >= data.size()) {
+					ok = false;
+					return v;
 				}
+				uint8_t b = data[at++];
+				v |= static_cast<uint32_t>(b & 0x7F) << shift;
+				if (!(b & 0x80)) return v;
 			}
+			ok = false;
+			return v;
+		};
+		auto unzigzag = [](uint32_t v) { return static_cast<int32_t>(v >> 1) ^ -static_cast<int32_t>(v & 1); };
 
-			// Spawn asteroids and bonus
-			if (spawnTimer >= spawnInterval && asteroids.size() < MAX_AST) {
-				asteroids.push_back(MakeAsteroid(C_WIDTH, C_HEIGHT, currentShape));
-				spawnTimer = 0.f;
-				spawnInterval = Utils::RandomFloat(C_SPAWN_MIN, C_SPAWN_MAX);
-			}
-            
-			bonusSpawnTimer += dt;
-			if (bonusSpawnTimer >= bonusSpawnInterval) {
-    			// Random spawn bonus 
-    			if (GetRandomValue(0, 99) < 50) {
-        			bonuses.emplace_back(C_WIDTH, C_HEIGHT);
-    			}
-    			bonusSpawnTimer = 0.f;
-			}
-
-			// Update projectiles - check if in boundries and move them forward
-			{
-				auto projectile_to_remove = std::remove_if(projectiles.begin(), projectiles.end(),
-					[dt](auto& projectile) {
-						return projectile.Update(dt);
-					});
-				projectiles.erase(projectile_to_remove, projectiles.end());
-			}
-
-			// Projectile-Asteroid collisions O(n^2)
-			for (auto pit = projectiles.begin(); pit != projectiles.end();) {
-				bool removed = false;
-
-				for (auto ait = asteroids.begin(); ait != asteroids.end(); ++ait) {
-					float dist = Vector2Distance((*pit).GetPosition(), (*ait)->GetPosition());
-					if (dist < (*pit).GetRadius() + (*ait)->GetRadius()) {
-
-						(*ait)->TakeDamage((*pit).GetDamage());
-						if ((*ait)->Damaged()) {
-							ait = asteroids.erase(ait);
-							switch ((*ait)->GetSize()) {
-                		    case Renderable::SMALL:
-                   				score += 2; break;
-                			case Renderable::MEDIUM:
-                    			score += 4; break;
-                			case Renderable::LARGE:
-                    			score += 8; break;
-                			case Renderable::VERYLARGE:
-                    			score += 10; break;
-                			default:
-                    			break;
-            				}
-						}
+		uint32_t timeMs = 0;
+		while (ok && at < data.size()) {
+			Event e{};
+			uint32_t delta = varint();
+			if (at + 2 > data.size()) return false;
+			e.type = static_cast<Type>(data[at] & 0x0F);
+			if (e.type == Type::MATCH_START) timeMs = 0;
+			timeMs += delta;
+			e.timeMs = timeMs;
+			e.player = static_cast<uint8_t>(data[at++] >> 4);
+			e.size = static_cast<uint8_t>(data[at] & 0x0F);
+			e.kind = static_cast<uint8_t>(data[at++] >> 4);
+			e.entity = static_cast<uint16_t>(varint());
+			e.amount = static_cast<int16_t>(unzigzag(varint()));
+			e.x = static_cast<int16_t>(unzigzag(varint()));
+			e.y = static_cast<int16_t>(unzigzag(varint()));
+			if (!ok || static_cast<size_t>(e.type) >= TYPE_COUNT) return false;
+			fn(e);
+		}
+		return ok;
+	}
 
-						pit = projectiles.erase(pit);
-						removed = true;
-						break;
-					}
+	// Main.exe --replay <telemetry file>
+	// Rebuilds the aggregate stats of a recorded session
+	static int Replay(int argc, char** argv) {
+		if (argc != 3) {
+			printf("usage: Main.exe --replay <telemetry file>\n");
+			return 1;
+		}
+		Totals totals;
+		auto start = std::chrono::steady_clock::now();
+		if (!ReadTelemetry(argv[2], [&](const Event& e) { totals.Add(e); })) {
+			printf("%s: not a telemetry file or truncated\n", argv[2]);
+			return 1;
+		}
+		double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		totals.Print();
+		printf("replayed in %.1f ms\n", ms);
+		return 0;
+	}
+}
+
+// --- WORLD ---
+// One independent match. Owns all entities and its own RNG; touches no globals, so any number
+// of worlds can be simulated side by side on different threads
+class World {
+public:
+	World(int w, int h, uint64_t seed, std::unique_ptr<Ship> ship, const Tuning& balance = {})
+		: screenW(w), screenH(h), rng(seed), tuning(balance)
+	{
+		pilots.reserve(MAX_PLAYERS);
+		AddPlayer(std::move(ship));
+		tuning.maxAsteroids = std::clamp(tuning.maxAsteroids, 0, C_MAX_ASTEROIDS);
+		asteroids.reserve(C_MAX_ASTEROIDS);
+		commands.spawns.reserve(C_MAX_ASTEROIDS);
+		commands.removals.reserve(C_MAX_ASTEROIDS);
+		// everything a running match needs is allocated up front, so Tick() stays off the heap. Each pool
+		// holds as many asteroids of its size as can be alive at once
+		for (size_t i = 0; i < asteroidPool.size(); ++i) {
+			size_t count = PoolSize(tuning, static_cast<int>(i));
+			asteroidPool[i].reserve(count);
+			for (size_t n = 0; n < count; ++n) {
+				asteroidPool[i].push_back(NewAsteroid(static_cast<int>(i)));
+			}
+		}
+		for (auto& batch : projectiles) {
+			batch.reserve(C_MAX_PROJECTILES);
+		}
+		bonuses.reserve(MAX_BONUSES);
+		asteroidIndex.Reserve(C_MAX_ASTEROIDS, screenW, screenH);
+		spawnInterval = rng.Float(tuning.spawnInterval[0], tuning.spawnInterval[1]);
+	}
+
+	// Co-op: further ships share the score; returns the player index used by Tick's inputs
+	size_t AddPlayer(std::unique_ptr<Ship> ship) {
+		pilots.push_back({ std::move(ship), 0.f, WeaponType::LASER });
+		return pilots.size() - 1;
+	}
+
+	void SetShape(AsteroidShape shape) {
+		currentShape = shape;
+	}
+
+	// Seconds between edge spawns from now on
+	void SetSpawnInterval(float min, float max) {
+		tuning.spawnInterval[0] = min;
+		tuning.spawnInterval[1] = max;
+		spawnInterval = std::min(spawnInterval, max);
+	}
+
+	void Tick(float dt, const ShipInput& input) {
+		Tick(dt, &input, 1);
+	}
+
+	// inputs[i] drives player i; players without an input get an idle one
+	void Tick(float dt, const ShipInput* inputs, size_t count) {
+		elapsed += dt;
+		spawnTimer += dt;
+		events.Clear();
+		if (!started) {
+			Events::Event e = Events::Make(Events::Type::MATCH_START, 0.f, {});
+			e.amount = static_cast<int16_t>(pilots.size());
+			events.Push(e);
+			started = true;
+		}
+
+		for (size_t i = 0; i < pilots.size(); ++i) {
+			Pilot& pilot = pilots[i];
+			const ShipInput input = i < count ? inputs[i] : ShipInput{};
+			const uint8_t player = static_cast<uint8_t>(i);
+
+			// Update player
+			pilot.ship->Update(dt, input);
+
+			if (input.weapon != pilot.weapon) {
+				Events::Event e = Events::Make(Events::Type::WEAPON_SWITCH, elapsed, pilot.ship->GetPosition(), player);
+				e.kind = static_cast<uint8_t>(input.weapon);
+				events.Push(e);
+				pilot.weapon = input.weapon;
+			}
+
+			// Shooting
+			const WeaponDesc& weapon = tuning.weapons[static_cast<size_t>(input.weapon)];
+			float interval = 1.f / weapon.fireRate;
+
+			if (pilot.ship->IsAlive() && input.fire) {
+				pilot.shotTimer += dt;
+
+				while (pilot.shotTimer >= interval) {
+					Vector2 p = pilot.ship->GetPosition();
+					p.y -= pilot.ship->GetRadius();
+					fire(weapon, p, player);
+					pilot.shotTimer -= interval;
 				}
-				if (!removed) {
-					++pit;
+			}
+			else {
+				if (pilot.shotTimer > interval) {
+					pilot.shotTimer = fmodf(pilot.shotTimer, interval);
 				}
 			}
+		}
+
+		// Spawn asteroids and bonus
+		if (spawnTimer >= spawnInterval && asteroids.size() < static_cast<size_t>(tuning.maxAsteroids)) {
+			int sizeIndex = PickShape(currentShape, rng, tuning);
+			if (auto asteroid = acquireAsteroid(sizeIndex)) {
+				asteroid->SpawnAtEdge(screenW, screenH, rng, tuning);
+				asteroid->SetNetId(nextNetId++);
+				pushSpawn(Events::SPAWN_EDGE, sizeIndex, *asteroid);
+				asteroids.push_back(std::move(asteroid));
+			}
+			spawnTimer = 0.f;
+			spawnInterval = rng.Float(tuning.spawnInterval[0], tuning.spawnInterval[1]);
+		}
 
-			// Asteroid-Ship collisions
-			{
-				auto remove_collision =
-					[&player, dt](auto& asteroid_ptr_like) -> bool {
-					if (player->IsAlive()) {
-						float dist = Vector2Distance(player->GetPosition(), asteroid_ptr_like->GetPosition());
+		bonusSpawnTimer += dt;
+		if (bonusSpawnTimer >= bonusSpawnInterval) {
+    		// Random spawn bonus
+    		if (rng.Int(0, 99) < 50 && bonuses.size() < MAX_BONUSES) {
+        		bonuses.emplace_back(screenW, screenH, rng);
+        		bonuses.back().SetNetId(nextNetId++);
+        		Events::Event e = Events::Make(Events::Type::SPAWN, elapsed, bonuses.back().GetPosition());
+        		e.kind = Events::SPAWN_BONUS;
+        		e.entity = bonuses.back().NetId();
+        		events.Push(e);
+    		}
+    		bonusSpawnTimer = 0.f;
+		}
 
-						if (dist < player->GetRadius() + asteroid_ptr_like->GetRadius()) {
-							player->TakeDamage(asteroid_ptr_like->GetDamage());
-							return true; // Mark asteroid for removal due to collision
-						}
-					}
-					if (!asteroid_ptr_like->Update(dt)) {
-						return true;
-					}
-					return false; // Keep the asteroid
-					};
-				auto asteroid_to_remove = std::remove_if(asteroids.begin(), asteroids.end(), remove_collision);
-				asteroids.erase(asteroid_to_remove, asteroids.end());
+		// Update projectiles - check if in boundries and move them forward
+		asteroidIndex.Build(asteroids, screenW, screenH);
+		updateProjectiles<ProjectileKind::LASER>(dt);
+		updateProjectiles<ProjectileKind::BULLET>(dt);
+		updateProjectiles<ProjectileKind::BEAM>(dt);
+		updateProjectiles<ProjectileKind::MISSILE>(dt);
+
+		// Projectile-Asteroid collisions O(n^2)
+		collideProjectiles<ProjectileKind::LASER>();
+		collideProjectiles<ProjectileKind::BULLET>();
+		collideProjectiles<ProjectileKind::BEAM>();
+		collideProjectiles<ProjectileKind::MISSILE>();
+
+		// Asteroid-Ship collisions
+		for (size_t i = 0; i < asteroids.size(); ++i) {
+			Asteroid& asteroid = *asteroids[i];
+			if (asteroid.IsRemoved()) continue;
+			bool rammed = false;
+			for (Pilot& pilot : pilots) {
+				if (!pilot.ship->IsAlive()) continue;
+				float dist = Vector2Distance(pilot.ship->GetPosition(), asteroid.GetPosition());
+
+				if (dist < pilot.ship->GetRadius() + asteroid.GetRadius()) {
+					// applied right away: later collisions this tick must see the ship dead
+					pilot.ship->TakeDamage(asteroid.GetDamage());
+					Events::Event e = Events::Make(Events::Type::DAMAGE, elapsed, pilot.ship->GetPosition(), static_cast<uint8_t>(&pilot - pilots.data()));
+					e.size = static_cast<uint8_t>(SizeIndex(static_cast<Renderable::Size>(asteroid.GetSize())));
+					e.entity = asteroid.NetId();
+					e.amount = static_cast<int16_t>(asteroid.GetDamage());
+					events.Push(e);
+					removeAsteroid(i); // Mark asteroid for removal due to collision
+					rammed = true;
+					break;
+				}
 			}
+			if (rammed) continue;
+			if (!asteroid.Update(dt, screenW, screenH)) {
+				removeAsteroid(i);
+			}
+		}
 
 
-			{
-    			auto bonus_to_remove = std::remove_if(bonuses.begin(), bonuses.end(),
-        			[&](Bonus& bonus) {
-            			if (!player->IsAlive()) return false;
-            			if (!bonus.Update(dt, C_WIDTH, C_HEIGHT)) return true;
+		{
+    		auto bonus_to_remove = std::remove_if(bonuses.begin(), bonuses.end(),
+        		[&](Bonus& bonus) {
+            		if (!AnyAlive()) return false;
+            		if (!bonus.Update(dt, screenW, screenH)) return true;
 
-            			float dist = Vector2Distance(player->GetPosition(), bonus.GetPosition());
-            			if (dist < player->GetRadius() + bonus.GetRadius()) {
-                		player->TakeDamage(-10); // Dodaj 10 HP (ujemne obrażenia = leczenie)
+            		for (Pilot& pilot : pilots) {
+                		if (!pilot.ship->IsAlive()) continue;
+                		float dist = Vector2Distance(pilot.ship->GetPosition(), bonus.GetPosition());
+                		if (dist < pilot.ship->GetRadius() + bonus.GetRadius()) {
+                			// leczenie (+10 HP) dolicza consumeEvents na końcu ticku
+                			Events::Event e = Events::Make(Events::Type::PICKUP, elapsed, bonus.GetPosition(), static_cast<uint8_t>(&pilot - pilots.data()));
+                			e.entity = bonus.NetId();
+                			e.amount = BONUS_HEAL;
+                			events.Push(e);
                 			return true; // usuwamy bonus
-            			}
-            			return false;
-        			});
-    			bonuses.erase(bonus_to_remove, bonuses.end());
-			}
+                		}
+            		}
+            		return false;
+        		});
+    		bonuses.erase(bonus_to_remove, bonuses.end());
+		}
+
+		applyCommands();
+		consumeEvents();
+
+		if (AnyAlive()) {
+			survivalTime = elapsed;
+		}
+	}
+
+	void Draw() const {
+		drawProjectiles<ProjectileKind::LASER>();
+		drawProjectiles<ProjectileKind::BULLET>();
+		drawProjectiles<ProjectileKind::BEAM>();
+		drawProjectiles<ProjectileKind::MISSILE>();
+		for (const auto& astPtr : asteroids) {
+			astPtr->Draw();
+		}
+		for (const auto& bonus : bonuses) {
+    		bonus.Draw();
+		}
+		for (const Pilot& pilot : pilots) {
+			pilot.ship->Draw();
+		}
+	}
 
+	// fn(position, radius, color) for every entity that casts light
+	template <typename Fn>
+	void ForEachLight(Fn&& fn) const {
+		lightProjectiles<ProjectileKind::LASER>(fn);
+		lightProjectiles<ProjectileKind::BULLET>(fn);
+		lightProjectiles<ProjectileKind::BEAM>(fn);
+		lightProjectiles<ProjectileKind::MISSILE>(fn);
+		for (const Bonus& bonus : bonuses) {
+			fn(bonus.GetPosition(), BONUS_LIGHT_RADIUS, GOLD);
+		}
+	}
 
-			// Render everything
-			{
-				Renderer::Instance().Begin();
+	const Ship& Player(size_t index = 0) const { return *pilots[index].ship; }
+	size_t PlayerCount() const { return pilots.size(); }
+	bool AnyAlive() const {
+		return std::any_of(pilots.begin(), pilots.end(), [](const Pilot& p) { return p.ship->IsAlive(); });
+	}
+	const std::vector<std::unique_ptr<Asteroid>>& Asteroids() const { return asteroids; }
+	const std::vector<Projectile>& Projectiles(ProjectileKind kind) const { return projectiles[static_cast<size_t>(kind)]; }
+	const std::vector<Bonus>& Bonuses() const { return bonuses; }
+	int Width() const { return screenW; }
+	int Height() const { return screenH; }
+	int Score() const { return score; }
+	int Kills() const { return kills; }
+	float SurvivalTime() const { return survivalTime; }
+	// Everything the last Tick recorded, in order
+	const Events::Buffer& TickEvents() const { return events; }
 
-				DrawText(TextFormat("HP: %d", player->GetHP()),
-					10, 10, 20, GREEN);
+private:
+	// Fans the weapon's pellets around straight up and drops them into the batch of their kind
+	void fire(const WeaponDesc& weapon, Vector2 pos, uint8_t owner) {
+		float speed = weapon.spacing * weapon.fireRate;
+		auto& batch = projectiles[static_cast<size_t>(weapon.kind)];
+		for (int i = 0; i < weapon.pellets && batch.size() < C_MAX_PROJECTILES; ++i) {
+			float angle = 0.f;
+			if (weapon.pellets > 1) {
+				angle = (-0.5f + float(i) / float(weapon.pellets - 1)) * weapon.spread * DEG2RAD;
+			}
+			Vector2 vel = Vector2Rotate({ 0, -speed }, angle);
+			batch.push_back({ pos, vel, weapon.damage, std::min(weapon.pierce, MAX_PIERCE), nextNetId++, owner, 0, {} });
+		}
+	}
 
-				const char* weaponName = (currentWeapon == WeaponType::LASER) ? "LASER" : "BULLET";
-				DrawText(TextFormat("Weapon: %s", weaponName),
-					10, 40, 20, BLUE);
+	template <ProjectileKind K>
+	void updateProjectiles(float dt) {
+		using Traits = ProjectileTraits<K>;
+		auto& batch = projectiles[static_cast<size_t>(K)];
 
-				for (const auto& projPtr : projectiles) {
-					projPtr.Draw();
+		size_t kept = 0;
+		for (size_t i = 0; i < batch.size(); ++i) {
+			Projectile p = batch[i];
+			if constexpr (Traits::HOMING) {
+				Vector2 target{};
+				if (asteroidIndex.Nearest(p.position, Traits::SEEK_RANGE, target)) {
+					float speed = Vector2Length(p.velocity);
+					Vector2 desired = Vector2Scale(Vector2Normalize(Vector2Subtract(target, p.position)), speed);
+					Vector2 steered = Vector2Lerp(p.velocity, desired, fminf(1.f, Traits::TURN_RATE * dt));
+					p.velocity = Vector2Scale(Vector2Normalize(steered), speed);
 				}
-				for (const auto& astPtr : asteroids) {
-					astPtr->Draw();
-				}
-                DrawText(TextFormat("Score: %d", score), 10, 70, 20, YELLOW);
-				for (const auto& bonus : bonuses) {
-    				bonus.Draw();
-				}
-				player->Draw();
+			}
+			p.position = Vector2Add(p.position, Vector2Scale(p.velocity, dt));
+			batch[kept] = p;
+			kept += (p.position.x >= 0 && p.position.x <= screenW && p.position.y >= 0 && p.position.y <= screenH) ? 1 : 0;
+		}
+		batch.resize(kept);
+	}
+
+	template <ProjectileKind K>
+	void collideProjectiles() {
+		using Traits = ProjectileTraits<K>;
+		auto& batch = projectiles[static_cast<size_t>(K)];
 
-				if (!player->IsAlive()) {
-    			DrawText("GAME OVER", C_WIDTH / 2 - MeasureText("GAME OVER", 60) / 2, C_HEIGHT / 2 - 30, 60, RED);
-				DrawText(TextFormat("Final Score: %d", score), C_WIDTH / 2 - MeasureText(TextFormat("Final Score: %d", score), 30) / 2, C_HEIGHT / 2 + 30, 30, YELLOW);
-    			DrawText("Press [R] to Restart", C_WIDTH / 2 - MeasureText("Press [R] to Restart", 30) / 2, C_HEIGHT / 2 + 70, 30, WHITE);
+		size_t kept = 0;
+		for (size_t i = 0; i < batch.size(); ++i) {
+			Projectile& p = batch[i];
+			bool removed = false;
+
+			for (size_t a = 0; a < asteroids.size(); ++a) {
+				Asteroid* hit = asteroids[a].get();
+				if (hit->IsRemoved()) continue;
+				if constexpr (Traits::PIERCE) {
+					if (std::find(p.hitIds, p.hitIds + p.hitCount, hit->NetId()) != p.hitIds + p.hitCount) continue;
 				}
+				if (ProjectileOverlaps<K>(p.position, *hit)) {
+
+					hit->TakeDamage(p.damage);
+					Events::Event e = Events::Make(Events::Type::HIT, elapsed, hit->GetPosition(), p.owner);
+					e.size = static_cast<uint8_t>(SizeIndex(static_cast<Renderable::Size>(hit->GetSize())));
+					e.kind = static_cast<uint8_t>(K);
+					e.entity = hit->NetId();
+					e.amount = static_cast<int16_t>(p.damage);
+					events.Push(e);
+					if (hit->Damaged()) {
+						e.type = Events::Type::KILL;
+						e.amount = 0;
+						events.Push(e);
+						queueFragments(*hit);
+						removeAsteroid(a);
+					}
 
-				Renderer::Instance().End();
+					if constexpr (Traits::PIERCE) {
+						p.hitIds[p.hitCount++] = hit->NetId();    // at most hitsLeft + 1 entries before removal
+						removed = p.hitsLeft-- <= 0;
+					}
+					else {
+						removed = true;
+					}
+					break;
+				}
+			}
+			if (!removed) {
+				batch[kept++] = p;
 			}
 		}
+		batch.resize(kept);
 	}
 
-private:
-	Application()
-	{
-		asteroids.reserve(1000);
-		projectiles.reserve(10'000);
+	template <ProjectileKind K>
+	void drawProjectiles() const {
+		for (const Projectile& p : projectiles[static_cast<size_t>(K)]) {
+			DrawProjectile<K>(p.position, p.velocity);
+		}
+	}
+
+	template <ProjectileKind K, typename Fn>
+	void lightProjectiles(Fn& fn) const {
+		for (const Projectile& p : projectiles[static_cast<size_t>(K)]) {
+			EmitProjectileLight<K>(p.position, fn);
+		}
+	}
+
+	// Spawns and removals recorded while the asteroid list is being iterated, applied together at
+	// the end of the tick. Nothing is inserted or erased mid-iteration, so indices stay valid
+	struct Commands {
+		struct Spawn {
+			int     sizeIndex;
+			Vector2 position;
+			Vector2 velocity;
+		};
+		std::vector<Spawn>  spawns;
+		std::vector<size_t> removals;    // indices into asteroids, each at most once
 	};
 
+	void removeAsteroid(size_t index) {
+		asteroids[index]->MarkRemoved();
+		commands.removals.push_back(index);
+	}
+
+	// Pieces of the next smaller shape, flying apart symmetrically around the parent's velocity so
+	// together they keep its momentum
+	void queueFragments(const Asteroid& parent) {
+		int parentIdx = SizeIndex(static_cast<Renderable::Size>(parent.GetSize()));
+		int count = tuning.fragments[parentIdx];
+		if (parentIdx == 0 || count <= 0) return;
+
+		float childRadius = parent.GetRadius() * 0.5f;
+		float base = rng.Float(0, 2 * PI);
+		float kick = rng.Float(FRAGMENT_KICK_MIN, FRAGMENT_KICK_MAX);
+		for (int i = 0; i < count; ++i) {
+			float angle = base + 2 * PI * i / count;
+			Vector2 dir = { cosf(angle), sinf(angle) };
+			commands.spawns.push_back({ parentIdx - 1,
+				Vector2Add(parent.GetPosition(), Vector2Scale(dir, childRadius)),
+				Vector2Add(parent.GetVelocity(), Vector2Scale(dir, kick)) });
+		}
+	}
+
+	// Removed asteroids go back to their shape's pool; one stable compaction pass, then the spawns
+	void applyCommands() {
+		if (!commands.removals.empty()) {
+			for (size_t index : commands.removals) {
+				auto& slot = asteroids[index];
+				asteroidPool[static_cast<size_t>(SizeIndex(static_cast<Renderable::Size>(slot->GetSize())))].push_back(std::move(slot));
+			}
+			asteroids.erase(std::remove(asteroids.begin(), asteroids.end(), nullptr), asteroids.end());
+			commands.removals.clear();
+		}
+
+		for (const auto& spawn : commands.spawns) {
+			auto asteroid = acquireAsteroid(spawn.sizeIndex);
+			if (!asteroid) continue;
+			asteroid->SpawnFragment(spawn.position, spawn.velocity, rng, tuning);
+			asteroid->SetNetId(nextNetId++);
+			pushSpawn(Events::SPAWN_FRAGMENT, spawn.sizeIndex, *asteroid);
+			asteroids.push_back(std::move(asteroid));
+		}
+		commands.spawns.clear();
+	}
+
+	// nullptr at C_MAX_ASTEROIDS alive, the hard cap that fragments can reach with a generous tuning.
+	// PoolSize keeps the pool itself from running dry before that
+	std::unique_ptr<Asteroid> acquireAsteroid(int sizeIndex) {
+		auto& pool = asteroidPool[static_cast<size_t>(sizeIndex)];
+		if (pool.empty() || asteroids.size() >= static_cast<size_t>(C_MAX_ASTEROIDS)) {
+			return nullptr;
+		}
+		auto asteroid = std::move(pool.back());
+		pool.pop_back();
+		return asteroid;
+	}
+
+	// Most asteroids of one size alive at once. Edge spawns stop at maxAsteroids alive, and each live
+	// asteroid can still break into at most `reach` of this size (the fragment counts multiplied down
+	// the chain), so maxAsteroids * reach bounds it
+	static size_t PoolSize(const Tuning& tuning, int sizeIndex) {
+		int reach = 1;
+		int line = 1;
+		for (int parent = sizeIndex + 1; parent < 4 && tuning.fragments[parent] > 0; ++parent) {
+			line = std::min(line * tuning.fragments[parent], C_MAX_ASTEROIDS);
+			reach = std::max(reach, line);
+		}
+		return static_cast<size_t>(std::min(tuning.maxAsteroids * reach, C_MAX_ASTEROIDS));
+	}
+
+	void pushSpawn(Events::SpawnSource source, int sizeIndex, const Asteroid& asteroid) {
+		Events::Event e = Events::Make(Events::Type::SPAWN, elapsed, asteroid.GetPosition());
+		e.size = static_cast<uint8_t>(sizeIndex);
+		e.kind = source;
+		e.entity = asteroid.NetId();
+		events.Push(e);
+	}
+
+	// End of tick: scoring and pickups act on what the tick recorded
+	void consumeEvents() {
+		for (const Events::Event& e : events) {
+			switch (e.type) {
+			case Events::Type::KILL:
+				++kills;
+				score += Events::KILL_POINTS[e.size];
+				break;
+			case Events::Type::PICKUP:
+				pilots[e.player].ship->TakeDamage(-e.amount);    // ujemne obrażenia = leczenie
+				break;
+			default:
+				break;
+			}
+		}
+	}
+
+	int screenW;
+	int screenH;
+	Utils::Rng rng;
+	Tuning tuning;
+
+	struct Pilot {
+		std::unique_ptr<Ship> ship;
+		float shotTimer;
+		WeaponType weapon;    // last selected, for WEAPON_SWITCH events
+	};
+	std::vector<Pilot> pilots;
 	std::vector<std::unique_ptr<Asteroid>> asteroids;
-	std::vector<Projectile> projectiles;
+	std::array<std::vector<std::unique_ptr<Asteroid>>, 4> asteroidPool;    // by size index
+	Commands commands;
+	std::array<std::vector<Projectile>, PROJECTILE_KIND_COUNT> projectiles;
+	std::vector<Bonus> bonuses;
+	AsteroidIndex asteroidIndex;
+	Events::Buffer events{ GAMEPLAY_EVENTS };
+	bool started = false;    // MATCH_START recorded
 
 	AsteroidShape currentShape = AsteroidShape::RANDOM;
 
-	int score = 0;
-	std::vector<Bonus> bonuses;
+	float spawnTimer = 0.f;
+	float spawnInterval = 0.f;
     float bonusSpawnTimer = 0.f;
     float bonusSpawnInterval = 5.f;  // Bonus co ~10 sekund
-	static constexpr int C_WIDTH = 1600;
-	static constexpr int C_HEIGHT = 1600;
-	static constexpr size_t MAX_AST = 150;
-	static constexpr float C_SPAWN_MIN = 0.5f;
-	static constexpr float C_SPAWN_MAX = 3.0f;
+	float elapsed = 0.f;
+	float survivalTime = 0.f;
 
-	static constexpr int C_MAX_ASTEROIDS = 1000;
-	static constexpr int C_MAX_PROJECTILES = 10'000;
-};
+	int score = 0;
+	int kills = 0;
+	uint16_t nextNetId = 0;     // wraps; ids only have to outlive a replicated entity (see Net)
+
+public:
+	static constexpr size_t MAX_PLAYERS = 4;
+	static constexpr size_t MAX_AST = 150;
+	static constexpr size_t MAX_BONUSES = 32;    // after death bonuses are never picked up, so they would pile up
+	static constexpr int16_t BONUS_HEAL = 10;
+
+	static constexpr float FRAGMENT_KICK_MIN = 40.f;
+	static constexpr float FRAGMENT_KICK_MAX = 90.f;
+
+	static constexpr int C_MAX_ASTEROIDS = 10 * static_cast<int>(MAX_AST);
+	static constexpr size_t C_MAX_PROJECTILES = 10'000;
+
+	// per tick at most one KILL per asteroid, one PICKUP per bonus and the MATCH_START
+	static constexpr size_t GAMEPLAY_EVENTS = static_cast<size_t>(C_MAX_ASTEROIDS) + MAX_BONUSES + 1;
+};
+
+// --- BATCH RUNNER ---
+// Headless Monte Carlo matches for balance tuning: Main.exe --batch <matches> [options]
+namespace Batch {
+	static constexpr int C_WIDTH = 1600;
+	static constexpr int C_HEIGHT = 1600;
+	static constexpr float DANGER_DIST = 150.f;
+
+	struct Config {
+		int      matches = 1000;
+		int      threads = 0;         // 0 = all hardware threads
+		uint64_t seed = 1;
+		float    maxTime = 300.f;     // match is cut off after this many simulated seconds
+		float    dt = 1.f / 60.f;
+		WeaponType weapon = WeaponType::LASER;
+		Tuning   tuning;
+		Events::TelemetryWriter* telemetry = nullptr;    // records every match; single producer, so one thread
+	};
+
+	struct MatchResult {
+		int   score;
+		int   kills;
+		float survivalTime;
+		bool  survived;
+	};
+
+	// Scripted pilot: always shoots, steers away from close asteroids and drifts back to its home point.
+	// forEachAsteroid(fn) calls fn(position, radius) for every asteroid the pilot knows about
+	template <typename ForEachAsteroid>
+	static ShipInput SteerBot(Vector2 pos, float shipRadius, Vector2 home, WeaponType weapon, ForEachAsteroid&& forEachAsteroid) {
+		ShipInput input;
+		input.fire = true;
+		input.weapon = weapon;
+
+		Vector2 push = {
+			(home.x - pos.x) * 0.004f,
+			(home.y - pos.y) * 0.004f
+		};
+		forEachAsteroid([&](Vector2 position, float radius) {
+			Vector2 away = Vector2Subtract(pos, position);
+			float gap = Vector2Length(away) - radius - shipRadius;
+			if (gap < DANGER_DIST) {
+				push = Vector2Add(push, Vector2Scale(Vector2Normalize(away), (DANGER_DIST - gap) / DANGER_DIST));
+			}
+		});
+
+		input.left = push.x < -0.1f;
+		input.right = push.x > 0.1f;
+		input.up = push.y < -0.1f;
+		input.down = push.y > 0.1f;
+		return input;
+	}
+
+	// Bot for player 0, homed on the lower middle
+	static ShipInput BotInput(const World& world, WeaponType weapon) {
+		const Ship& ship = world.Player();
+		Vector2 home = { world.Width() * 0.5f, world.Height() * 0.75f };
+		return SteerBot(ship.GetPosition(), ship.GetRadius(), home, weapon, [&](auto&& visit) {
+			for (const auto& asteroid : world.Asteroids()) {
+				visit(asteroid->GetPosition(), asteroid->GetRadius());
+			}
+		});
+	}
+
+	static MatchResult RunMatch(const Config& cfg, uint64_t seed, Events::TelemetryWriter* telemetry = nullptr) {
+		World world(C_WIDTH, C_HEIGHT, seed, std::make_unique<HeadlessShip>(C_WIDTH, C_HEIGHT), cfg.tuning);
+
+		for (float t = 0.f; t < cfg.maxTime && world.Player().IsAlive(); t += cfg.dt) {
+			world.Tick(cfg.dt, BotInput(world, cfg.weapon));
+			if (telemetry) telemetry->Submit(world.TickEvents());
+		}
+		return { world.Score(), world.Kills(), world.SurvivalTime(), world.Player().IsAlive() };
+	}
+
+	// Matches are handed out through a single atomic counter; each result slot is written by exactly one worker
+	static std::vector<MatchResult> Run(const Config& cfg) {
+		std::vector<MatchResult> results(static_cast<size_t>(cfg.matches));
+		std::atomic<int> next{ 0 };
+
+		auto worker = [&]() {
+			for (int i = next.fetch_add(1); i < cfg.matches; i = next.fetch_add(1)) {
+				results[static_cast<size_t>(i)] = RunMatch(cfg, cfg.seed + static_cast<uint64_t>(i), cfg.telemetry);
+			}
+		};
+
+		int threads = cfg.threads > 0 ? cfg.threads : std::max(1, static_cast<int>(std::thread::hardware_concurrency()));
+		std::vector<std::thread> pool;
+		for (int i = 1; i < threads; ++i) {
+			pool.emplace_back(worker);
+		}
+		worker();
+		for (auto& th : pool) {
+			th.join();
+		}
+		return results;
+	}
+
+	static void PrintStat(const char* name, std::vector<float> values) {
+		std::sort(values.begin(), values.end());
+		double sum = 0.0;
+		double sumSq = 0.0;
+		for (float v : values) {
+			sum += v;
+			sumSq += double(v) * v;
+		}
+		double n = double(values.size());
+		double mean = sum / n;
+		double stddev = sqrt(std::max(0.0, sumSq / n - mean * mean));
+		auto pct = [&](double p) { return values[static_cast<size_t>(p * (values.size() - 1))]; };
+		printf("%-10s mean %9.2f  sd %9.2f  min %9.2f  p10 %9.2f  p50 %9.2f  p90 %9.2f  max %9.2f\n",
+			name, mean, stddev, values.front(), pct(0.1), pct(0.5), pct(0.9), values.back());
+	}
+
+	// Reads "a,b,c" into dst; returns false on a malformed list
+	template <typename T>
+	static bool ParseList(const char* s, T* dst, int count) {
+		for (int i = 0; i < count; ++i) {
+			char* end = nullptr;
+			double v = strtod(s, &end);
+			if (end == s) return false;
+			dst[i] = static_cast<T>(v);
+			s = end;
+			if (i + 1 < count) {
+				if (*s != ',') return false;
+				++s;
+			}
+		}
+		return *s == '\0';
+	}
+
+	static int Main(int argc, char** argv) {
+		Config cfg;
+		if (argc > 2) cfg.matches = atoi(argv[2]);
+		Events::TelemetryWriter telemetry;
+		const char* telemetryPath = nullptr;
+		int scaling = 0;
+
+		bool ok = cfg.matches > 0;
+		for (int i = 3; ok && i + 1 < argc; i += 2) {
+			const char* key = argv[i];
+			const char* val = argv[i + 1];
+			if (!strcmp(key, "--threads")) cfg.threads = atoi(val);
+			else if (!strcmp(key, "--seed")) cfg.seed = strtoull(val, nullptr, 10);
+			else if (!strcmp(key, "--time")) cfg.maxTime = static_cast<float>(atof(val));
+			else if (!strcmp(key, "--mix")) ok = ParseList(val, cfg.tuning.spawnWeights, 4);
+			else if (!strcmp(key, "--hp")) ok = ParseList(val, cfg.tuning.hp, 4);
+			else if (!strcmp(key, "--damage")) ok = ParseList(val, cfg.tuning.baseDamage, 4);
+			else if (!strcmp(key, "--fragments")) ok = ParseList(val, cfg.tuning.fragments, 4);
+			else if (!strcmp(key, "--spawn")) ok = ParseList(val, cfg.tuning.spawnInterval, 2);
+			else if (!strcmp(key, "--max-asteroids")) {
+				cfg.tuning.maxAsteroids = atoi(val);
+				ok = cfg.tuning.maxAsteroids > 0 && cfg.tuning.maxAsteroids <= World::C_MAX_ASTEROIDS;
+			}
+			else if (!strcmp(key, "--telemetry")) telemetryPath = val;
+			else if (!strcmp(key, "--scaling")) ok = (scaling = atoi(val)) > 0;
+			else if (!strcmp(key, "--firerate")) {
+				float rates[WEAPON_COUNT];
+				ok = ParseList(val, rates, WEAPON_COUNT);
+				for (int w = 0; ok && w < WEAPON_COUNT; ++w) {
+					cfg.tuning.weapons[static_cast<size_t>(w)].fireRate = rates[w];
+				}
+			}
+			else if (!strcmp(key, "--weapon")) {
+				auto it = std::find_if(WEAPONS.begin(), WEAPONS.end(), [val](const WeaponDesc& w) { return !strcmp(w.name, val); });
+				ok = it != WEAPONS.end();
+				cfg.weapon = static_cast<WeaponType>(it - WEAPONS.begin());
+			}
+			else ok = false;
+		}
+		if (!ok || (argc > 3 && argc % 2 == 0)) {
+			printf("usage: Main.exe --batch <matches> [--threads N] [--seed S] [--time SECONDS]\n"
+				"                  [--mix t,s,p,v] [--hp t,s,p,v] [--damage t,s,p,v] [--fragments t,s,p,v]\n"
+				"                  [--spawn min,max] [--max-asteroids N] [--weapon NAME] [--telemetry FILE]\n"
+				"                  [--scaling MAX_THREADS]\n"
+				"                  [--firerate laser,bullet,spread,beam,homing]\n");
+			return 1;
+		}
+		if (telemetryPath) {
+			if (!telemetry.Open(telemetryPath)) {
+				printf("cannot write %s\n", telemetryPath);
+				return 1;
+			}
+			cfg.telemetry = &telemetry;
+			cfg.threads = 1;    // matches go into the file one after another
+		}
+
+		if (scaling > 0) {
+			// Same matches on 1, 2, 4 ... MAX_THREADS workers; throughput should grow linearly with cores
+			double single = 0.0;
+			for (int threads = 1; ; threads = std::min(threads * 2, scaling)) {
+				Config run = cfg;
+				run.threads = threads;
+				auto begin = std::chrono::steady_clock::now();
+				Run(run);
+				double rate = cfg.matches / std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+				if (threads == 1) single = rate;
+				printf("%3d threads: %9.1f matches/s  %5.2fx  %3.0f%% efficiency\n", threads, rate, rate / single, 100.0 * rate / single / threads);
+				if (threads == scaling) break;
+			}
+			printf("%u hardware threads\n", std::thread::hardware_concurrency());
+			return 0;
+		}
+
+		auto start = std::chrono::steady_clock::now();
+		std::vector<MatchResult> results = Run(cfg);
+		double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		std::vector<float> scores, survival, kills;
+		int survivors = 0;
+		double simSeconds = 0.0;
+		for (const auto& r : results) {
+			scores.push_back(float(r.score));
+			kills.push_back(float(r.kills));
+			survival.push_back(r.survivalTime);
+			survivors += r.survived ? 1 : 0;
+			simSeconds += r.survivalTime;
+		}
+
+		printf("%d matches, seed %llu, %.3f s wall, %.1f matches/s, %.0fx realtime\n",
+			cfg.matches, static_cast<unsigned long long>(cfg.seed), wall, cfg.matches / wall, simSeconds / wall);
+		PrintStat("score", scores);
+		PrintStat("kills", kills);
+		PrintStat("survival", survival);
+		printf("survived full %.0f s: %.1f%%\n", cfg.maxTime, 100.0 * survivors / cfg.matches);
+		if (telemetryPath) {
+			telemetry.Close();
+			printf("telemetry: %s, %llu events, %llu bytes, %llu dropped\n", telemetryPath,
+				static_cast<unsigned long long>(telemetry.Written()), static_cast<unsigned long long>(telemetry.Bytes()),
+				static_cast<unsigned long long>(telemetry.Dropped()));
+
+			// the file must replay into exactly what the matches reported
+			Events::Totals replayed;
+			bool read = Events::ReadTelemetry(telemetryPath, [&](const Events::Event& e) { replayed.Add(e); });
+			int score = 0;
+			int matchKills = 0;
+			double lived = 0.0;
+			for (const auto& r : results) {
+				score += r.score;
+				matchKills += r.kills;
+				lived += r.survivalTime;
+			}
+			bool match = read && replayed.matches == cfg.matches && replayed.score == score && replayed.kills == matchKills;
+			printf("replay check: %d matches, score %d, kills %d, %.1f s (live: %d, %d, %d, %.1f s survived) %s\n",
+				replayed.matches, replayed.score, replayed.kills, replayed.Duration(), cfg.matches, score, matchKills, lived,
+				match ? "ok" : "MISMATCH");
+			if (!match) return 1;
+		}
+		return 0;
+	}
+
+	// Main.exe --alloc-test [--seed S] [--warmup SECONDS] [--time SECONDS] [--frames N]
+	// Simulation half of the test (the frame loop is Application::AllocTest, which gets `frames`): one bot
+	// match per weapon, then a stress match at World::C_MAX_ASTEROIDS (10x the normal cap): an edge spawn
+	// every tick, 4-way fragmentation and an invulnerable ship firing a wide piercing fan, so kills chain
+	// into bursts of fragments. After the warmup every Tick() must stay off the heap, and the stress match
+	// must fill at least half its cap; otherwise exit code 1
+	static int AllocTest(int argc, char** argv, int& frames) {
+		uint64_t seed = 1;
+		float warmup = 30.f;
+		float duration = 120.f;
+		bool ok = argc % 2 == 0;
+		for (int i = 2; ok && i + 1 < argc; i += 2) {
+			const char* key = argv[i];
+			const char* val = argv[i + 1];
+			if (!strcmp(key, "--seed")) seed = strtoull(val, nullptr, 10);
+			else if (!strcmp(key, "--warmup")) warmup = static_cast<float>(atof(val));
+			else if (!strcmp(key, "--time")) duration = static_cast<float>(atof(val));
+			else if (!strcmp(key, "--frames")) frames = atoi(val);
+			else ok = false;
+		}
+		if (!ok || frames < 1) {
+			printf("usage: Main.exe --alloc-test [--seed S] [--warmup SECONDS] [--time SECONDS] [--frames N]\n");
+			return 1;
+		}
+
+		Memory::Scope tag(Memory::Tag::ENTITIES);
+		const float dt = 1.f / 60.f;
+		int failures = 0;
+		auto play = [&](const char* name, WeaponType weapon, const Tuning& tuning) {
+			Memory::Totals before = Memory::Sum();
+			World world(C_WIDTH, C_HEIGHT, seed, std::make_unique<HeadlessShip>(C_WIDTH, C_HEIGHT), tuning);
+			Memory::Totals setup = Memory::Sum();
+
+			size_t peak = 0;
+			for (float t = 0.f; t < warmup; t += dt) {
+				world.Tick(dt, BotInput(world, weapon));
+				peak = std::max(peak, world.Asteroids().size());
+			}
+
+			uint64_t allocs = 0;
+			uint64_t bytes = 0;
+			float firstAt = -1.f;
+			for (float t = 0.f; t < duration; t += dt) {
+				Memory::Totals start = Memory::Sum();
+				world.Tick(dt, BotInput(world, weapon));
+				Memory::Totals end = Memory::Sum();
+				if (end.allocs != start.allocs && firstAt < 0.f) firstAt = warmup + t;
+				allocs += end.allocs - start.allocs;
+				bytes += end.bytes - start.bytes;
+				peak = std::max(peak, world.Asteroids().size());
+			}
+
+			printf("%-7s setup %llu allocs / %.1f KB, steady state %llu allocs / %llu B, peak %zu asteroids%s",
+				name, static_cast<unsigned long long>(setup.allocs - before.allocs), (setup.bytes - before.bytes) / 1024.0,
+				static_cast<unsigned long long>(allocs), static_cast<unsigned long long>(bytes), peak,
+				world.Player().IsAlive() ? "" : " (ship died)");
+			if (allocs > 0) {
+				printf("  FAIL, first at %.2f s\n", firstAt);
+				++failures;
+			}
+			else {
+				printf("  ok\n");
+			}
+			return peak;
+		};
+
+		for (int w = 0; w < WEAPON_COUNT; ++w) {
+			play(WEAPONS[static_cast<size_t>(w)].name, static_cast<WeaponType>(w), Tuning{});
+		}
+
+		Tuning stress;
+		stress.maxAsteroids = World::C_MAX_ASTEROIDS;
+		stress.spawnInterval[0] = 0.f;
+		stress.spawnInterval[1] = 0.f;
+		for (int i = 0; i < 4; ++i) {
+			stress.fragments[i] = i > 0 ? 4 : 0;
+			stress.baseDamage[i] = 0;
+		}
+		WeaponDesc& fan = stress.weapons[static_cast<size_t>(WeaponType::BEAM)];
+		fan.fireRate = 60.f;
+		fan.pellets = 32;
+		fan.spread = 170.f;
+		size_t peak = play("STRESS", WeaponType::BEAM, stress);
+		if (peak < static_cast<size_t>(stress.maxAsteroids / 2)) {
+			printf("stress match peaked at %zu asteroids, below %d\n", peak, stress.maxAsteroids / 2);
+			++failures;
+		}
+		return failures > 0 ? 1 : 0;
+	}
+
+	static constexpr double COLLISION_BUDGET = 1.2;    // hull test vs circle-only, see CollisionBench
+
+	// The projectile/asteroid pass of World::collideProjectiles without its side effects; returns projectiles that hit
+	template <ProjectileKind K, bool HULL>
+	static size_t CollisionPass(const std::vector<Projectile>& projectiles, const std::vector<std::unique_ptr<Asteroid>>& asteroids) {
+		size_t hits = 0;
+		for (const Projectile& p : projectiles) {
+			for (const auto& asteroid : asteroids) {
+				if (ProjectileOverlaps<K, HULL>(p.position, *asteroid)) {
+					++hits;
+					break;
+				}
+			}
+		}
+		return hits;
+	}
+
+	// One pass, in ms
+	template <ProjectileKind K, bool HULL>
+	static double TimePass(const std::vector<Projectile>& projectiles, const std::vector<std::unique_ptr<Asteroid>>& asteroids, size_t& hits) {
+		auto begin = std::chrono::steady_clock::now();
+		hits = CollisionPass<K, HULL>(projectiles, asteroids);
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - begin).count();
+	}
+
+	// count projectiles of kind K flying up at their weapon's speed, the way a match holds them: a
+	// projectile that touched an asteroid a tick ago was consumed then, so each one is either in open
+	// space or just arrived
+	template <ProjectileKind K>
+	static std::vector<Projectile> ProjectileField(int count, const std::vector<std::unique_ptr<Asteroid>>& asteroids, Utils::Rng& rng) {
+		auto weapon = std::find_if(WEAPONS.begin(), WEAPONS.end(), [](const WeaponDesc& w) { return w.kind == K; });
+		float step = weapon->spacing * weapon->fireRate / 60.f;
+		std::vector<Projectile> field;
+		while (static_cast<int>(field.size()) < count) {
+			Vector2 position = { rng.Float(0, C_WIDTH), rng.Float(0, C_HEIGHT) };
+			Vector2 previous = { position.x, position.y + step };
+			bool consumed = std::any_of(asteroids.begin(), asteroids.end(), [&](const auto& a) { return ProjectileOverlaps<K>(previous, *a); });
+			if (!consumed) field.push_back({ position, { 0.f, -step * 60.f }, 0, 0, 0, 0, 0, {} });
+		}
+		return field;
+	}
+
+	template <ProjectileKind K>
+	static bool BenchKind(const char* name, int count, const std::vector<std::unique_ptr<Asteroid>>& asteroids, Utils::Rng& rng) {
+		std::vector<Projectile> projectiles = ProjectileField<K>(count, asteroids, rng);
+		// best of REPEATS, alternating so both see the same machine noise
+		static constexpr int REPEATS = 41;
+		size_t circleHits = 0;
+		size_t hullHits = 0;
+		double circle = DBL_MAX;
+		double hull = DBL_MAX;
+		for (int r = 0; r < REPEATS; ++r) {
+			circle = std::min(circle, TimePass<K, false>(projectiles, asteroids, circleHits));
+			hull = std::min(hull, TimePass<K, true>(projectiles, asteroids, hullHits));
+		}
+		bool ok = hull <= circle * COLLISION_BUDGET;
+		printf("%-8s circle %7.3f ms  hull %7.3f ms  %+6.1f%%  hits %zu -> %zu  %s\n", name, circle, hull,
+			100.0 * (hull / circle - 1.0), circleHits, hullHits, ok ? "ok" : "OVER BUDGET");
+		return ok;
+	}
+
+	// Main.exe --collision-bench [--projectiles N] [--asteroids N] [--seed S]
+	// Times one collision pass per projectile kind with the exact hull test against the circle-only
+	// reject; exit code 1 if the hull test costs more than COLLISION_BUDGET times the baseline
+	static int CollisionBench(int argc, char** argv) {
+		uint64_t seed = 1;
+		int projectileCount = static_cast<int>(World::C_MAX_PROJECTILES);
+		int asteroidCount = static_cast<int>(World::MAX_AST);
+		bool ok = argc % 2 == 0;
+		for (int i = 2; ok && i + 1 < argc; i += 2) {
+			const char* key = argv[i];
+			const char* val = argv[i + 1];
+			if (!strcmp(key, "--seed")) seed = strtoull(val, nullptr, 10);
+			else if (!strcmp(key, "--projectiles")) ok = (projectileCount = atoi(val)) > 0;
+			else if (!strcmp(key, "--asteroids")) ok = (asteroidCount = atoi(val)) > 0;
+			else ok = false;
+		}
+		if (!ok) {
+			printf("usage: Main.exe --collision-bench [--projectiles N] [--asteroids N] [--seed S]\n");
+			return 1;
+		}
+
+		// the spawn mix at random places and angles
+		Utils::Rng rng(seed);
+		Tuning tuning;
+		std::vector<std::unique_ptr<Asteroid>> asteroids;
+		for (int i = 0; i < asteroidCount; ++i) {
+			asteroids.push_back(NewAsteroid(PickShape(AsteroidShape::RANDOM, rng, tuning)));
+			asteroids.back()->SpawnFragment({ rng.Float(0, C_WIDTH), rng.Float(0, C_HEIGHT) }, {}, rng, tuning);
+		}
+
+		printf("%d projectiles x %d asteroids, budget +%.0f%%\n", projectileCount, asteroidCount, 100.0 * (COLLISION_BUDGET - 1.0));
+		bool within = BenchKind<ProjectileKind::LASER>("laser", projectileCount, asteroids, rng);
+		within &= BenchKind<ProjectileKind::BULLET>("bullet", projectileCount, asteroids, rng);
+		within &= BenchKind<ProjectileKind::BEAM>("beam", projectileCount, asteroids, rng);
+		within &= BenchKind<ProjectileKind::MISSILE>("missile", projectileCount, asteroids, rng);
+		return within ? 0 : 1;
+	}
+}
+
+// --- NETWORK CO-OP ---
+// 2-4 player co-op on a server-authoritative World, over UDP on 127.0.0.1.
+// Clients send their inputs (repeated, since packets get lost), predict their own ship and replay the inputs
+// the server has not processed yet whenever its copy of the ship arrives. Everything else is drawn from
+// per-client snapshots: quantized, delta-encoded against the newest snapshot that client acknowledged and
+// filled in priority order up to a fixed byte budget. Priority accumulates while an entity waits and grows
+// with proximity to the client's ship, and projectiles far from it are not sent at all, so a client's
+// bandwidth is capped by the budget however many asteroids are alive - far ones just update less often and
+// are extrapolated in between
+namespace Net {
+	static constexpr int      C_WIDTH = 1600;
+	static constexpr int      C_HEIGHT = 1600;
+	static constexpr uint32_t PROTOCOL_ID = 0x41535431;        // "AST1"
+	static constexpr float    TICK_DT = 1.f / 60.f;
+	static constexpr uint32_t SNAPSHOT_INTERVAL = 3;           // ticks between snapshots (20 Hz)
+	static constexpr float    FLOOD_SPAWN[2] = { 0.02f, 0.05f };    // --net-test flood phase spawn interval, s
+	static constexpr int      MAX_PACKET = 1200;
+	static constexpr int      SNAPSHOT_BUDGET = 1000;          // bytes per snapshot, headers included
+	static constexpr uint32_t HISTORY = 32;                    // snapshots kept as delta baselines
+	static constexpr uint32_t INPUT_BUFFER = 64;
+	static constexpr uint32_t INPUT_REDUNDANCY = 12;           // past inputs repeated in every input packet
+	static constexpr uint32_t MAX_INPUT_LAG = 8;               // queued inputs beyond this are skipped to bound latency
+	static constexpr int      MAX_REMOVALS = 48;               // per snapshot
+	static constexpr float    PROJECTILE_INTEREST = 700.f;     // projectiles farther from the client's ship are not sent
+	static constexpr float    VIEW_MARGIN = 64.f;
+	static constexpr float    BONUS_RADIUS = 25.f;
+	static constexpr size_t   MAX_IDS = 65536;
+	static constexpr size_t   MAX_PLAYERS = World::MAX_PLAYERS;
+	static constexpr uint32_t NONE = 0xFFFFFFFF;
+	static constexpr uint32_t LOOPBACK = 0x7F000001;
+
+	enum class PacketType : uint8_t { CONNECT, ACCEPT, INPUT, SNAPSHOT };
+
+	struct Address {
+		uint32_t ip = 0;
+		uint16_t port = 0;
+
+		bool operator==(const Address& other) const {
+			return ip == other.ip && port == other.port;
+		}
+	};
+
+	// sockaddr_in as laid out on Windows and Linux, with port and ip in network byte order
+	struct SockAddrIn {
+		uint16_t family;
+		uint8_t  port[2];
+		uint8_t  ip[4];
+		uint8_t  zero[8];
+	};
+
+	static SockAddrIn ToSockAddr(const Address& address) {
+		SockAddrIn sa = {};
+		sa.family = 2;    // AF_INET
+		sa.port[0] = static_cast<uint8_t>(address.port >> 8);
+		sa.port[1] = static_cast<uint8_t>(address.port);
+		for (int i = 0; i < 4; ++i) {
+			sa.ip[i] = static_cast<uint8_t>(address.ip >> (24 - 8 * i));
+		}
+		return sa;
+	}
+
+	static Address FromSockAddr(const SockAddrIn& sa) {
+		Address address;
+		address.port = static_cast<uint16_t>((sa.port[0] << 8) | sa.port[1]);
+		address.ip = (uint32_t(sa.ip[0]) << 24) | (uint32_t(sa.ip[1]) << 16) | (uint32_t(sa.ip[2]) << 8) | sa.ip[3];
+		return address;
+	}
+
+	// Non-blocking UDP socket bound to 127.0.0.1
+	class Socket {
+	public:
+		~Socket() {
+			Close();
+		}
+
+		bool Open(uint16_t port) {
+			Close();
+#if defined(_WIN32)
+			static bool started = false;
+			if (!started) {
+				alignas(8) char wsaData[512];
+				started = WSAStartup(0x0202, wsaData) == 0;
+			}
+			handle = socket(2 /*AF_INET*/, 2 /*SOCK_DGRAM*/, 17 /*IPPROTO_UDP*/);
+			if (handle == INVALID) return false;
+			unsigned long nonBlocking = 1;
+			ioctlsocket(handle, static_cast<long>(0x8004667Eu) /*FIONBIO*/, &nonBlocking);
+			SockAddrIn sa = ToSockAddr({ LOOPBACK, port });
+			int length = sizeof(sa);
+			bool ok = bind(handle, &sa, sizeof(sa)) == 0 && getsockname(handle, &sa, &length) == 0;
+#else
+			handle = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+			if (handle == INVALID) return false;
+			fcntl(handle, F_SETFL, O_NONBLOCK);
+			SockAddrIn sa = ToSockAddr({ LOOPBACK, port });
+			socklen_t length = sizeof(sa);
+			bool ok = bind(handle, reinterpret_cast<const sockaddr*>(&sa), sizeof(sa)) == 0 &&
+				getsockname(handle, reinterpret_cast<sockaddr*>(&sa), &length) == 0;
+#endif
+			if (!ok) {
+				Close();
+				return false;
+			}
+			local = FromSockAddr(sa);
+			return true;
+		}
+
+		void Close() {
+			if (handle == INVALID) return;
+#if defined(_WIN32)
+			closesocket(handle);
+#else
+			close(handle);
+#endif
+			handle = INVALID;
+		}
+
+		void Send(const Address& to, const void* data, int size) {
+			SockAddrIn sa = ToSockAddr(to);
+#if defined(_WIN32)
+			sendto(handle, static_cast<const char*>(data), size, 0, &sa, sizeof(sa));
+#else
+			sendto(handle, data, static_cast<size_t>(size), 0, reinterpret_cast<const sockaddr*>(&sa), sizeof(sa));
+#endif
+		}
+
+		// Bytes received, or -1 when nothing is waiting
+		int Receive(void* buffer, int capacity, Address& from) {
+			SockAddrIn sa = {};
+#if defined(_WIN32)
+			int length = sizeof(sa);
+			int size = recvfrom(handle, static_cast<char*>(buffer), capacity, 0, &sa, &length);
+#else
+			socklen_t length = sizeof(sa);
+			int size = static_cast<int>(recvfrom(handle, buffer, static_cast<size_t>(capacity), 0, reinterpret_cast<sockaddr*>(&sa), &length));
+#endif
+			if (size < 0) return -1;
+			from = FromSockAddr(sa);
+			return size;
+		}
+
+		const Address& Local() const {
+			return local;
+		}
+
+	private:
+#if defined(_WIN32)
+		using Handle = uintptr_t;
+		static constexpr Handle INVALID = ~Handle(0);
+#else
+		using Handle = int;
+		static constexpr Handle INVALID = -1;
+#endif
+		Handle  handle = INVALID;
+		Address local;
+	};
+
+	// Seconds of one-way delay, +- jitter seconds, and the fraction of packets dropped
+	struct LinkConditions {
+		float latency = 0.f;
+		float jitter = 0.f;
+		float loss = 0.f;
+	};
+
+	// Socket whose outgoing packets go through a simulated bad link: held back by latency +- jitter (which
+	// also reorders them) or dropped, before being sent for real on Flush
+	class Endpoint {
+	public:
+		bool Open(uint16_t port, const LinkConditions& link, uint64_t seed) {
+			conditions = link;
+			rng = Utils::Rng(seed);
+			queue.reserve(QUEUE_CAPACITY);
+			return socket.Open(port);
+		}
+
+		void Send(const Address& to, const uint8_t* data, int size, double now) {
+			++packetsSent;
+			bytesSent += static_cast<uint64_t>(size);
+			if (rng.Float(0.f, 1.f) < conditions.loss || queue.size() >= QUEUE_CAPACITY) {
+				++packetsDropped;
+				return;
+			}
+			Pending& p = queue.emplace_back();
+			p.due = now + conditions.latency + rng.Float(-conditions.jitter, conditions.jitter);
+			p.to = to;
+			p.size = size;
+			memcpy(p.data.data(), data, static_cast<size_t>(size));
+		}
+
+		void Flush(double now) {
+			size_t kept = 0;
+			for (size_t i = 0; i < queue.size(); ++i) {
+				if (queue[i].due <= now) {
+					socket.Send(queue[i].to, queue[i].data.data(), queue[i].size);
+				}
+				else {
+					if (kept != i) queue[kept] = queue[i];
+					++kept;
+				}
+			}
+			queue.resize(kept);
+		}
+
+		int Receive(uint8_t* buffer, int capacity, Address& from) {
+			int size = socket.Receive(buffer, capacity, from);
+			if (size > 0) bytesReceived += static_cast<uint64_t>(size);
+			return size;
+		}
+
+		const Address& Local() const { return socket.Local(); }
+
+		uint64_t bytesSent = 0;
+		uint64_t bytesReceived = 0;
+		uint64_t packetsSent = 0;
+		uint64_t packetsDropped = 0;
+
+	private:
+		struct Pending {
+			double  due;
+			Address to;
+			int     size;
+			std::array<uint8_t, MAX_PACKET> data;
+		};
+		static constexpr size_t QUEUE_CAPACITY = 256;
+
+		Socket socket;
+		LinkConditions conditions;
+		Utils::Rng rng{ 0 };
+		std::vector<Pending> queue;
+	};
+
+	// --- bit packing ---
+	class BitWriter {
+	public:
+		BitWriter(uint8_t* data, int capacity) : buffer(data), capacityBits(capacity * 8) {
+			memset(buffer, 0, static_cast<size_t>(capacity));
+		}
+
+		void Write(uint32_t value, int bits) {
+			for (int i = bits - 1; i >= 0; --i) {
+				if (bitPos >= capacityBits) {
+					overflow = true;
+					return;
+				}
+				uint8_t mask = static_cast<uint8_t>(0x80 >> (bitPos & 7));
+				if ((value >> i) & 1u) buffer[bitPos >> 3] |= mask;
+				else buffer[bitPos >> 3] &= static_cast<uint8_t>(~mask);
+				++bitPos;
+			}
+		}
+
+		void WriteSigned(int32_t value, int bits) {
+			Write(static_cast<uint32_t>(value) & (bits == 32 ? ~0u : ((1u << bits) - 1)), bits);
+		}
+
+		// small residuals (the common case after extrapolation) take 7 bits, anything else 18
+		void WriteResidual(int32_t value) {
+			if (value >= -32 && value < 32) {
+				Write(0, 1);
+				WriteSigned(value, 6);
+			}
+			else {
+				Write(1, 1);
+				WriteSigned(value, 17);
+			}
+		}
+
+		int  Bits() const { return bitPos; }
+		int  Bytes() const { return (bitPos + 7) / 8; }
+		bool Overflow() const { return overflow; }
+
+		void Rewind(int bits) {
+			bitPos = bits;
+			overflow = false;
+		}
+
+	private:
+		uint8_t* buffer;
+		int      capacityBits;
+		int      bitPos = 0;
+		bool     overflow = false;
+	};
+
+	class BitReader {
+	public:
+		BitReader(const uint8_t* data, int size) : buffer(data), sizeBits(size * 8) {}
+
+		uint32_t Read(int bits) {
+			uint32_t value = 0;
+			for (int i = 0; i < bits; ++i) {
+				if (bitPos >= sizeBits) {
+					overflow = true;
+					return 0;
+				}
+				value = (value << 1) | ((buffer[bitPos >> 3] >> (7 - (bitPos & 7))) & 1u);
+				++bitPos;
+			}
+			return value;
+		}
+
+		int32_t ReadSigned(int bits) {
+			uint32_t value = Read(bits);
+			if (bits < 32 && (value & (1u << (bits - 1)))) value |= ~((1u << bits) - 1);
+			return static_cast<int32_t>(value);
+		}
+
+		int32_t ReadResidual() {
+			return Read(1) ? ReadSigned(17) : ReadSigned(6);
+		}
+
+		bool Overflow() const { return overflow; }
+
+	private:
+		const uint8_t* buffer;
+		int            sizeBits;
+		int            bitPos = 0;
+		bool           overflow = false;
+	};
+
+	// --- replicated state ---
+	// Types 0-3 are asteroid size indices, then the bonus, then one type per projectile kind
+	static constexpr uint8_t TYPE_BONUS = 4;
+	static constexpr uint8_t TYPE_PROJECTILE = 5;
+
+	static bool IsAsteroid(uint8_t type) {
+		return type < TYPE_BONUS;
+	}
+
+	// Quantized entity: position in 1/4 px, velocity in 1/16 px/s, rotation in 1/256 turn, spin in 2 deg/s
+	struct EntityState {
+		uint16_t id;
+		uint8_t  type;
+		uint8_t  rotation;
+		int16_t  x, y;
+		int16_t  vx, vy;
+		int8_t   spin;
+		uint16_t hp;
+	};
+
+	static int16_t Quantize(float value, float scale) {
+		return static_cast<int16_t>(Clamp(roundf(value * scale), -32768.f, 32767.f));
+	}
+
+	static EntityState QuantizeState(uint16_t id, uint8_t type, Vector2 position, Vector2 velocity, float rotation = 0.f, float spin = 0.f, int hp = 0) {
+		EntityState s = {};
+		s.id = id;
+		s.type = type;
+		s.x = Quantize(position.x, 4.f);
+		s.y = Quantize(position.y, 4.f);
+		s.vx = Quantize(velocity.x, 16.f);
+		s.vy = Quantize(velocity.y, 16.f);
+		float turns = rotation / 360.f;
+		s.rotation = static_cast<uint8_t>(static_cast<int>(floorf((turns - floorf(turns)) * 256.f)) & 255);
+		s.spin = static_cast<int8_t>(Clamp(roundf(spin * 0.5f), -128.f, 127.f));
+		s.hp = static_cast<uint16_t>(Clamp(static_cast<float>(hp), 0.f, 65535.f));
+		return s;
+	}
+
+	static Vector2 StatePosition(const EntityState& s) { return { s.x * 0.25f, s.y * 0.25f }; }
+	static Vector2 StateVelocity(const EntityState& s) { return { s.vx / 16.f, s.vy / 16.f }; }
+	static float   StateRotation(const EntityState& s) { return s.rotation * (360.f / 256.f); }
+	static float   StateSpin(const EntityState& s) { return s.spin * 2.f; }
+
+	// A dead ship falls forever in the server's World; on the wire and in the client's prediction it stops
+	// just below the screen, so its position stays inside Quantize's range and both ends agree on it
+	static constexpr float PARKED_Y = C_HEIGHT + VIEW_MARGIN;
+	static Vector2 ShipPosition(const Ship& s) {
+		Vector2 p = s.GetPosition();
+		if (!s.IsAlive()) p.y = std::min(p.y, PARKED_Y);
+		return p;
+	}
+	static void StepShip(Ship& s, const ShipInput& input) {
+		s.Update(TICK_DT, input);
+		if (!s.IsAlive() && s.GetPosition().y > PARKED_Y) s.SetState(ShipPosition(s), s.GetHP(), false);
+	}
+
+	// Where the baseline would be after `ticks` more ticks, in integer units so both ends agree exactly
+	static void Extrapolate(const EntityState& base, uint32_t ticks, int32_t& x, int32_t& y, int32_t& rotation) {
+		int32_t t = static_cast<int32_t>(std::min(ticks, 600u));
+		x = base.x + base.vx * t / 240;                      // (1/16 px/s) * (1/60 s) -> 1/4 px
+		y = base.y + base.vy * t / 240;
+		rotation = base.rotation + base.spin * t * 512 / 21600;    // (2 deg/s) * (1/60 s) -> 1/256 turn
+	}
+
+	// Full state, or the difference to where the baseline copy of the entity would be by now
+	static void WriteEntity(BitWriter& w, const EntityState& s, const EntityState* base, uint32_t ticks) {
+		w.Write(s.id, 16);
+		bool full = !base || base->type != s.type;
+		w.Write(full ? 1u : 0u, 1);
+		if (full) {
+			w.Write(s.type, 4);
+			w.WriteSigned(s.x, 16);
+			w.WriteSigned(s.y, 16);
+			w.WriteSigned(s.vx, 16);
+			w.WriteSigned(s.vy, 16);
+			if (IsAsteroid(s.type)) {
+				w.Write(s.rotation, 8);
+				w.WriteSigned(s.spin, 8);
+				w.Write(s.hp, 16);
+			}
+			return;
+		}
+		int32_t x, y, rotation;
+		Extrapolate(*base, ticks, x, y, rotation);
+		w.WriteResidual(s.x - x);
+		w.WriteResidual(s.y - y);
+		bool velocityChanged = s.vx != base->vx || s.vy != base->vy;
+		w.Write(velocityChanged ? 1u : 0u, 1);
+		if (velocityChanged) {
+			w.WriteSigned(s.vx, 16);
+			w.WriteSigned(s.vy, 16);
+		}
+		if (IsAsteroid(s.type)) {
+			w.WriteSigned(static_cast<int8_t>(static_cast<uint8_t>(s.rotation - rotation)), 8);
+			bool hpChanged = s.hp != base->hp;
+			w.Write(hpChanged ? 1u : 0u, 1);
+			if (hpChanged) w.Write(s.hp, 16);
+		}
+	}
+
+	// Mirrors WriteEntity; the baseline is looked up by id after reading it. False if it is missing
+	template <typename FindBase>
+	static bool ReadEntity(BitReader& r, FindBase&& findBase, uint32_t ticks, EntityState& s) {
+		s = {};
+		s.id = static_cast<uint16_t>(r.Read(16));
+		if (r.Read(1)) {
+			s.type = static_cast<uint8_t>(r.Read(4));
+			s.x = static_cast<int16_t>(r.ReadSigned(16));
+			s.y = static_cast<int16_t>(r.ReadSigned(16));
+			s.vx = static_cast<int16_t>(r.ReadSigned(16));
+			s.vy = static_cast<int16_t>(r.ReadSigned(16));
+			if (IsAsteroid(s.type)) {
+				s.rotation = static_cast<uint8_t>(r.Read(8));
+				s.spin = static_cast<int8_t>(r.ReadSigned(8));
+				s.hp = static_cast<uint16_t>(r.Read(16));
+			}
+			return true;
+		}
+		const EntityState* base = findBase(s.id);
+		if (!base) return false;
+		s = *base;
+		int32_t x, y, rotation;
+		Extrapolate(*base, ticks, x, y, rotation);
+		s.x = static_cast<int16_t>(x + r.ReadResidual());
+		s.y = static_cast<int16_t>(y + r.ReadResidual());
+		if (r.Read(1)) {
+			s.vx = static_cast<int16_t>(r.ReadSigned(16));
+			s.vy = static_cast<int16_t>(r.ReadSigned(16));
+		}
+		if (IsAsteroid(s.type)) {
+			s.rotation = static_cast<uint8_t>(rotation + r.ReadSigned(8));
+			if (r.Read(1)) s.hp = static_cast<uint16_t>(r.Read(16));
+		}
+		return true;
+	}
+
+	// What one snapshot carried, kept on both ends so later snapshots can be delta-encoded against it
+	struct SnapshotRecord {
+		uint32_t seq = NONE;
+		uint32_t tick = 0;
+		std::vector<EntityState> entities;    // sorted by id
+		std::vector<uint16_t>    removals;
+
+		void Reset(uint32_t sequence, uint32_t serverTick) {
+			seq = sequence;
+			tick = serverTick;
+			entities.clear();
+			removals.clear();
+		}
+
+		void Seal() {
+			std::sort(entities.begin(), entities.end(), [](const EntityState& a, const EntityState& b) { return a.id < b.id; });
+		}
+
+		const EntityState* Find(uint16_t id) const {
+			auto it = std::lower_bound(entities.begin(), entities.end(), id, [](const EntityState& e, uint16_t v) { return e.id < v; });
+			return it != entities.end() && it->id == id ? &*it : nullptr;
+		}
+	};
+
+	static uint8_t PackInput(const ShipInput& input) {
+		return static_cast<uint8_t>((input.up ? 1 : 0) | (input.down ? 2 : 0) | (input.left ? 4 : 0) | (input.right ? 8 : 0) |
+			(input.fire ? 16 : 0) | (static_cast<int>(input.weapon) << 5));
+	}
+
+	static ShipInput UnpackInput(uint32_t bits) {
+		ShipInput input;
+		input.up = bits & 1;
+		input.down = bits & 2;
+		input.left = bits & 4;
+		input.right = bits & 8;
+		input.fire = bits & 16;
+		input.weapon = static_cast<WeaponType>(std::min<uint32_t>(bits >> 5, WEAPON_COUNT - 1));
+		return input;
+	}
+
+	static void WriteHeader(BitWriter& w, PacketType type) {
+		w.Write(PROTOCOL_ID, 32);
+		w.Write(static_cast<uint32_t>(type), 8);
+	}
+
+	// --- server ---
+	class Server {
+	public:
+		bool Open(uint16_t port, int playerCount, const LinkConditions& link, uint64_t seed, const Tuning& balance) {
+			players = std::clamp(playerCount, 1, static_cast<int>(MAX_PLAYERS));
+			worldSeed = seed;
+			tuning = balance;
+			candidates.reserve(World::MAX_AST * 10 + PROJECTILE_KIND_COUNT * World::C_MAX_PROJECTILES);
+			order.reserve(candidates.capacity());
+			return endpoint.Open(port, link, seed ^ 0x5E);
+		}
+
+		const Address& GetAddress() const { return endpoint.Local(); }
+		const World* GetWorld() const { return world.get(); }
+		World* GetWorld() { return world.get(); }
+		int Players() const { return players; }
+
+		void Tick(double now) {
+			receive(now);
+			if (!world && connected == players) {
+				world = std::make_unique<World>(C_WIDTH, C_HEIGHT, worldSeed, std::make_unique<HeadlessShip>(C_WIDTH, C_HEIGHT), tuning);
+				for (int i = 1; i < players; ++i) {
+					world->AddPlayer(std::make_unique<HeadlessShip>(C_WIDTH, C_HEIGHT));
+				}
+			}
+			if (world) {
+				std::array<ShipInput, MAX_PLAYERS> inputs{};
+				for (int i = 0; i < connected; ++i) {
+					inputs[static_cast<size_t>(i)] = nextInput(clients[static_cast<size_t>(i)]);
+				}
+				world->Tick(TICK_DT, inputs.data(), static_cast<size_t>(connected));
+				++tick;
+				if (tick % SNAPSHOT_INTERVAL == 0) {
+					gather();
+					for (int i = 0; i < connected; ++i) {
+						sendSnapshot(clients[static_cast<size_t>(i)], now);
+					}
+				}
+			}
+			endpoint.Flush(now);
+		}
+
+		struct ClientStats {
+			uint64_t snapshots = 0;
+			uint64_t entitiesSent = 0;
+			int      maxSnapshotBytes = 0;
+			uint64_t inputsStarved = 0;    // ticks the server had to repeat the client's previous input
+		};
+
+		const ClientStats& Stats(int player) const { return clients[static_cast<size_t>(player)].stats; }
+		const Endpoint& GetEndpoint() const { return endpoint; }
+
+	private:
+		enum : uint8_t { UNKNOWN, KNOWN, REMOVING };
+
+		struct ClientSlot {
+			Address  address;
+			uint8_t  player = 0;
+			uint32_t nextSeq = 0;
+			uint32_t ackedSeq = NONE;
+			std::array<SnapshotRecord, HISTORY> history;
+
+			// per entity id: priority accumulator, what the client may hold, relevance stamp
+			std::vector<float>    priority;
+			std::vector<uint8_t>  known;
+			std::vector<uint32_t> relevant;
+			std::vector<uint16_t> knownIds;
+			std::vector<uint16_t> pendingRemovals;
+
+			std::array<ShipInput, INPUT_BUFFER> inputs{};
+			std::array<uint32_t, INPUT_BUFFER>  inputTicks{};
+			uint32_t  lastInput = NONE;        // newest input tick applied
+			uint32_t  newestInput = NONE;      // newest input tick received
+			ShipInput current;
+
+			ClientStats stats;
+		};
+
+		struct Candidate {
+			EntityState state;
+			Vector2     position;
+			float       weight;
+			bool        projectile;
+		};
+
+		void receive(double now) {
+			uint8_t buffer[MAX_PACKET];
+			Address from;
+			int size;
+			while ((size = endpoint.Receive(buffer, MAX_PACKET, from)) >= 0) {
+				BitReader r(buffer, size);
+				if (r.Read(32) != PROTOCOL_ID) continue;
+				PacketType type = static_cast<PacketType>(r.Read(8));
+				ClientSlot* client = find(from);
+
+				if (type == PacketType::CONNECT) {
+					if (!client && connected < players) {
+						client = &clients[static_cast<size_t>(connected)];
+						*client = ClientSlot{};
+						client->address = from;
+						client->player = static_cast<uint8_t>(connected++);
+						client->priority.assign(MAX_IDS, 0.f);
+						client->known.assign(MAX_IDS, UNKNOWN);
+						client->relevant.assign(MAX_IDS, 0);
+						client->knownIds.reserve(MAX_IDS);
+						client->pendingRemovals.reserve(MAX_IDS);
+						for (SnapshotRecord& record : client->history) {
+							record.entities.reserve(SNAPSHOT_BUDGET / 4);
+							record.removals.reserve(MAX_REMOVALS);
+						}
+					}
+					if (client) {
+						uint8_t reply[16];
+						BitWriter w(reply, sizeof(reply));
+						WriteHeader(w, PacketType::ACCEPT);
+						w.Write(client->player, 8);
+						w.Write(static_cast<uint32_t>(players), 8);
+						endpoint.Send(from, reply, w.Bytes(), now);
+					}
+				}
+				else if (type == PacketType::INPUT && client) {
+					onInput(*client, r);
+				}
+			}
+		}
+
+		ClientSlot* find(const Address& address) {
+			for (int i = 0; i < connected; ++i) {
+				if (clients[static_cast<size_t>(i)].address == address) return &clients[static_cast<size_t>(i)];
+			}
+			return nullptr;
+		}
+
+		void onInput(ClientSlot& c, BitReader& r) {
+			uint32_t ack = r.Read(32);
+			uint32_t newest = r.Read(32);
+			uint32_t count = r.Read(5);
+			for (uint32_t i = 0; i < count && !r.Overflow() && i <= newest; ++i) {
+				uint32_t inputTick = newest - i;
+				ShipInput input = UnpackInput(r.Read(8));
+				if (r.Overflow()) return;
+				if (c.lastInput != NONE && inputTick <= c.lastInput) continue;
+				c.inputs[inputTick % INPUT_BUFFER] = input;
+				c.inputTicks[inputTick % INPUT_BUFFER] = inputTick;
+			}
+			if (c.newestInput == NONE || newest > c.newestInput) c.newestInput = newest;
+
+			// acknowledged removals are done; the client no longer holds those ids
+			if (ack != NONE && ack < c.nextSeq && (c.ackedSeq == NONE || ack > c.ackedSeq)) {
+				c.ackedSeq = ack;
+				const SnapshotRecord& record = c.history[ack % HISTORY];
+				if (record.seq == ack && !record.removals.empty()) {
+					for (uint16_t id : record.removals) {
+						if (c.known[id] == REMOVING) c.known[id] = UNKNOWN;
+					}
+					c.pendingRemovals.erase(std::remove_if(c.pendingRemovals.begin(), c.pendingRemovals.end(),
+						[&](uint16_t id) { return c.known[id] != REMOVING; }), c.pendingRemovals.end());
+					c.knownIds.erase(std::remove_if(c.knownIds.begin(), c.knownIds.end(),
+						[&](uint16_t id) { return c.known[id] == UNKNOWN; }), c.knownIds.end());
+				}
+			}
+		}
+
+		// One input per tick in order; a missing one repeats the previous input (the client's prediction
+		// is corrected by the next snapshot) and a backlog beyond MAX_INPUT_LAG is skipped
+		ShipInput nextInput(ClientSlot& c) {
+			if (c.newestInput == NONE) return c.current;
+			uint32_t next = c.lastInput == NONE ? c.newestInput : c.lastInput + 1;
+			if (c.newestInput >= next && c.newestInput - next > MAX_INPUT_LAG) {
+				next = c.newestInput - MAX_INPUT_LAG / 2;
+			}
+			if (c.inputTicks[next % INPUT_BUFFER] == next && c.newestInput >= next) {
+				c.current = c.inputs[next % INPUT_BUFFER];
+				c.lastInput = next;
+			}
+			else {
+				++c.stats.inputsStarved;
+			}
+			return c.current;
+		}
+
+		// Quantized state of everything on screen, shared by all clients' snapshots this tick
+		void gather() {
+			candidates.clear();
+			auto onScreen = [](Vector2 p, float r) {
+				return p.x > -VIEW_MARGIN - r && p.x < C_WIDTH + VIEW_MARGIN + r && p.y > -VIEW_MARGIN - r && p.y < C_HEIGHT + VIEW_MARGIN + r;
+			};
+			for (const auto& a : world->Asteroids()) {
+				if (a->IsRemoved() || !onScreen(a->GetPosition(), a->GetRadius())) continue;
+				uint8_t type = static_cast<uint8_t>(SizeIndex(static_cast<Renderable::Size>(a->GetSize())));
+				candidates.push_back({ QuantizeState(a->NetId(), type, a->GetPosition(), a->GetVelocity(), a->GetRotation(), a->GetRotationSpeed(), a->GetHP()),
+					a->GetPosition(), 1.f + 0.25f * type, false });
+			}
+			for (const Bonus& b : world->Bonuses()) {
+				candidates.push_back({ QuantizeState(b.NetId(), TYPE_BONUS, b.GetPosition(), b.GetVelocity()), b.GetPosition(), 2.f, false });
+			}
+			for (int k = 0; k < PROJECTILE_KIND_COUNT; ++k) {
+				ProjectileKind kind = static_cast<ProjectileKind>(k);
+				float weight = kind == ProjectileKind::MISSILE ? 1.f : 0.5f;    // missiles turn, the rest fly straight
+				for (const Projectile& p : world->Projectiles(kind)) {
+					candidates.push_back({ QuantizeState(p.netId, static_cast<uint8_t>(TYPE_PROJECTILE + k), p.position, p.velocity), p.position, weight, true });
+				}
+			}
+		}
+
+		void sendSnapshot(ClientSlot& c, double now) {
+			const Ship& ship = world->Player(c.player);
+			Vector2 eye = ship.GetPosition();
+			uint32_t stamp = tick;
+
+			// interest and priority accumulation
+			order.clear();
+			for (size_t i = 0; i < candidates.size(); ++i) {
+				const Candidate& cand = candidates[i];
+				float dist = Vector2Distance(eye, cand.position);
+				if (cand.projectile && dist > PROJECTILE_INTEREST) continue;
+				uint16_t id = cand.state.id;
+				c.relevant[id] = stamp;
+				float weight = cand.weight * 400.f / (400.f + dist);
+				if (c.known[id] != KNOWN) weight *= 4.f;    // new to this client: get it there fast
+				c.priority[id] += weight;
+				order.push_back({ c.priority[id], static_cast<uint32_t>(i) });
+			}
+			for (uint16_t id : c.knownIds) {
+				bool relevant = c.relevant[id] == stamp;
+				if (!relevant && c.known[id] == KNOWN) {
+					c.known[id] = REMOVING;
+					c.priority[id] = 0.f;
+					c.pendingRemovals.push_back(id);
+				}
+				else if (relevant && c.known[id] == REMOVING) {
+					c.known[id] = KNOWN;
+					c.pendingRemovals.erase(std::find(c.pendingRemovals.begin(), c.pendingRemovals.end(), id));
+				}
+			}
+			std::sort(order.begin(), order.end(), [](const Ranked& a, const Ranked& b) { return a.priority > b.priority; });
+
+			uint32_t seq = c.nextSeq++;
+			const SnapshotRecord* base = nullptr;
+			if (c.ackedSeq != NONE && seq - c.ackedSeq < HISTORY && c.history[c.ackedSeq % HISTORY].seq == c.ackedSeq) {
+				base = &c.history[c.ackedSeq % HISTORY];
+			}
+			SnapshotRecord& record = c.history[seq % HISTORY];
+			record.Reset(seq, tick);
+
+			uint8_t buffer[MAX_PACKET];
+			BitWriter w(buffer, MAX_PACKET);
+			WriteHeader(w, PacketType::SNAPSHOT);
+			w.Write(seq, 32);
+			w.Write(tick, 32);
+			w.Write(base ? base->seq : NONE, 32);
+			w.Write(c.lastInput, 32);
+			w.Write(static_cast<uint32_t>(world->Score()), 32);
+			w.Write(static_cast<uint32_t>(world->Kills()), 32);
+
+			w.Write(static_cast<uint32_t>(world->PlayerCount()), 3);
+			for (size_t i = 0; i < world->PlayerCount(); ++i) {
+				const Ship& s = world->Player(i);
+				Vector2 position = ShipPosition(s);
+				w.WriteSigned(Quantize(position.x, 4.f), 16);
+				w.WriteSigned(Quantize(position.y, 4.f), 16);
+				w.Write(s.GetHP() > 0xFFFF ? 0xFFFFu : static_cast<uint32_t>(s.GetHP()), 16);
+				w.Write(s.IsAlive() ? 1u : 0u, 1);
+				w.Write(PackInput(clients[i].current), 8);
+			}
+
+			int removals = std::min(static_cast<int>(c.pendingRemovals.size()), MAX_REMOVALS);
+			w.Write(static_cast<uint32_t>(removals), 6);
+			for (int i = 0; i < removals; ++i) {
+				uint16_t id = c.pendingRemovals[static_cast<size_t>(i)];
+				w.Write(id, 16);
+				record.removals.push_back(id);
+			}
+
+			// highest priority first until the budget is spent; one bit is kept for the terminator
+			for (const Ranked& ranked : order) {
+				const EntityState& state = candidates[ranked.index].state;
+				int mark = w.Bits();
+				w.Write(1, 1);
+				WriteEntity(w, state, base ? base->Find(state.id) : nullptr, base ? tick - base->tick : 0);
+				if (w.Overflow() || w.Bits() + 1 > SNAPSHOT_BUDGET * 8) {
+					w.Rewind(mark);
+					break;
+				}
+				record.entities.push_back(state);
+				c.priority[state.id] = 0.f;
+				if (c.known[state.id] == UNKNOWN) c.knownIds.push_back(state.id);
+				c.known[state.id] = KNOWN;
+			}
+			w.Write(0, 1);
+			record.Seal();
+
+			endpoint.Send(c.address, buffer, w.Bytes(), now);
+			++c.stats.snapshots;
+			c.stats.entitiesSent += record.entities.size();
+			c.stats.maxSnapshotBytes = std::max(c.stats.maxSnapshotBytes, w.Bytes());
+		}
+
+		struct Ranked {
+			float    priority;
+			uint32_t index;
+		};
+
+		Endpoint endpoint;
+		int      players = 2;
+		int      connected = 0;
+		uint64_t worldSeed = 1;
+		Tuning   tuning;
+		std::unique_ptr<World> world;
+		uint32_t tick = 0;
+
+		std::array<ClientSlot, MAX_PLAYERS> clients;
+		std::vector<Candidate> candidates;
+		std::vector<Ranked>    order;
+	};
+
+	// --- client ---
+	class Client {
+	public:
+		using ShipFactory = std::function<std::unique_ptr<Ship>()>;
+
+		bool Open(const Address& serverAddress, const LinkConditions& link, uint64_t seed, ShipFactory factory, const Tuning& balance = {}) {
+			server = serverAddress;
+			makeShip = std::move(factory);
+			tuning = balance;
+			replicas.assign(MAX_IDS, Replica{});
+			activeIds.reserve(MAX_IDS);
+			for (SnapshotRecord& record : history) {
+				record.entities.reserve(SNAPSHOT_BUDGET / 4);
+				record.removals.reserve(MAX_REMOVALS);
+			}
+			return endpoint.Open(0, link, seed);
+		}
+
+		// One fixed step: read the server, predict the own ship with `input`, send it
+		void Tick(const ShipInput& input, double now) {
+			receive();
+			if (!accepted) {
+				if (connectTicks++ % 10 == 0) {
+					uint8_t buffer[16];
+					BitWriter w(buffer, sizeof(buffer));
+					WriteHeader(w, PacketType::CONNECT);
+					endpoint.Send(server, buffer, w.Bytes(), now);
+				}
+				endpoint.Flush(now);
+				return;
+			}
+
+			// predict
+			Ship& own = *ships[player];
+			inputs[inputTick % INPUT_BUFFER] = input;
+			StepShip(own, input);
+			predicted[inputTick % INPUT_BUFFER] = own.GetPosition();
+
+			uint8_t buffer[64];
+			BitWriter w(buffer, sizeof(buffer));
+			WriteHeader(w, PacketType::INPUT);
+			w.Write(newestSeq, 32);
+			w.Write(inputTick, 32);
+			uint32_t count = std::min(inputTick + 1, INPUT_REDUNDANCY);
+			w.Write(count, 5);
+			for (uint32_t i = 0; i < count; ++i) {
+				w.Write(PackInput(inputs[(inputTick - i) % INPUT_BUFFER]), 8);
+			}
+			endpoint.Send(server, buffer, w.Bytes(), now);
+			endpoint.Flush(now);
+			++inputTick;
+
+			// everyone else moves on by extrapolation until the next snapshot
+			for (size_t i = 0; i < ships.size(); ++i) {
+				if (ships[i] && i != player) StepShip(*ships[i], remoteInputs[i]);
+			}
+			size_t kept = 0;
+			for (uint16_t id : activeIds) {
+				Replica& r = replicas[id];
+				advance(r, TICK_DT);
+				float radius = IsAsteroid(r.state.type) ? 16.f * float(1 << r.state.type) : BONUS_RADIUS;
+				if (r.position.x < -2 * VIEW_MARGIN - radius || r.position.x > C_WIDTH + 2 * VIEW_MARGIN + radius ||
+					r.position.y < -2 * VIEW_MARGIN - radius || r.position.y > C_HEIGHT + 2 * VIEW_MARGIN + radius) {
+					r.active = false;    // flew off; the server's removal may still be on its way
+				}
+				if (r.active) activeIds[kept++] = id;
+				else r.listed = false;
+			}
+			activeIds.resize(kept);
+		}
+
+		void Draw() const {
+			for (uint16_t id : activeIds) {
+				const Replica& r = replicas[id];
+				switch (r.state.type - TYPE_PROJECTILE) {
+				case static_cast<int>(ProjectileKind::LASER):   DrawProjectile<ProjectileKind::LASER>(r.position, r.velocity); break;
+				case static_cast<int>(ProjectileKind::BULLET):  DrawProjectile<ProjectileKind::BULLET>(r.position, r.velocity); break;
+				case static_cast<int>(ProjectileKind::BEAM):    DrawProjectile<ProjectileKind::BEAM>(r.position, r.velocity); break;
+				case static_cast<int>(ProjectileKind::MISSILE): DrawProjectile<ProjectileKind::MISSILE>(r.position, r.velocity); break;
+				default: break;
+				}
+			}
+			static constexpr int   SIDES[4] = { 3, 4, 5, 8 };
+			static constexpr Color BARS[4] = { WHITE, BLUE, PURPLE, MAGENTA };
+			for (uint16_t id : activeIds) {
+				const Replica& r = replicas[id];
+				if (IsAsteroid(r.state.type)) {
+					float hpFraction = float(r.state.hp) / float(std::max(1, tuning.hp[r.state.type]));
+					Asteroid::DrawShape(r.position, SIDES[r.state.type], 16.f * float(1 << r.state.type), r.rotation, hpFraction, BARS[r.state.type]);
+				}
+			}
+			for (uint16_t id : activeIds) {
+				if (replicas[id].state.type == TYPE_BONUS) DrawCircleV(replicas[id].position, BONUS_RADIUS, GOLD);
+			}
+			for (const auto& ship : ships) {
+				if (ship) ship->Draw();
+			}
+		}
+
+		// fn(position, radius, color) for every replicated projectile and bonus, like World::ForEachLight
+		template <typename Fn>
+		void ForEachLight(Fn&& fn) const {
+			for (uint16_t id : activeIds) {
+				const Replica& r = replicas[id];
+				switch (r.state.type - TYPE_PROJECTILE) {
+				case static_cast<int>(ProjectileKind::LASER):   EmitProjectileLight<ProjectileKind::LASER>(r.position, fn); break;
+				case static_cast<int>(ProjectileKind::BULLET):  EmitProjectileLight<ProjectileKind::BULLET>(r.position, fn); break;
+				case static_cast<int>(ProjectileKind::BEAM):    EmitProjectileLight<ProjectileKind::BEAM>(r.position, fn); break;
+				case static_cast<int>(ProjectileKind::MISSILE): EmitProjectileLight<ProjectileKind::MISSILE>(r.position, fn); break;
+				default:
+					if (r.state.type == TYPE_BONUS) fn(r.position, BONUS_LIGHT_RADIUS, GOLD);
+					break;
+				}
+			}
+		}
+
+		// fn(position, radius) for every replicated asteroid
+		template <typename Fn>
+		void ForEachAsteroid(Fn&& fn) const {
+			for (uint16_t id : activeIds) {
+				const Replica& r = replicas[id];
+				if (IsAsteroid(r.state.type)) fn(r.position, 16.f * float(1 << r.state.type));
+			}
+		}
+
+		bool Accepted() const { return accepted; }
+		size_t PlayerIndex() const { return player; }
+		size_t PlayerCount() const { return playerCount; }
+		const Ship& OwnShip() const { return *ships[player]; }
+		int Score() const { return score; }
+		int Kills() const { return kills; }
+		bool AnyAlive() const {
+			return std::any_of(ships.begin(), ships.begin() + static_cast<std::ptrdiff_t>(playerCount), [](const auto& s) { return s && s->IsAlive(); });
+		}
+
+		// Replicated position of an entity, if this client holds it
+		bool Find(uint16_t id, Vector2& position) const {
+			if (!replicas[id].active) return false;
+			position = replicas[id].position;
+			return true;
+		}
+
+		struct Stats {
+			uint64_t snapshots = 0;
+			uint64_t undecodable = 0;      // baseline already gone; the server falls back to full states
+			double   predictionError = 0.0;
+			float    maxPredictionError = 0.f;
+			uint64_t corrections = 0;      // snapshots that moved the own ship by more than half a pixel
+			float    roundTrip = 0.f;      // seconds, from the input the latest snapshot acknowledged
+		};
+
+		const Stats& GetStats() const { return stats; }
+		const Endpoint& GetEndpoint() const { return endpoint; }
+
+	private:
+		struct Replica {
+			EntityState state{};
+			Vector2     position{};
+			Vector2     velocity{};
+			float       rotation = 0.f;
+			bool        active = false;
+			bool        listed = false;    // in activeIds; a removal only clears `active`, Tick drops it from the list
+		};
+
+		void advance(Replica& r, float dt) const {
+			r.position = Vector2Add(r.position, Vector2Scale(r.velocity, dt));
+			r.rotation += StateSpin(r.state) * dt;
+		}
+
+		void receive() {
+			uint8_t buffer[MAX_PACKET];
+			Address from;
+			int size;
+			while ((size = endpoint.Receive(buffer, MAX_PACKET, from)) >= 0) {
+				if (!(from == server)) continue;
+				BitReader r(buffer, size);
+				if (r.Read(32) != PROTOCOL_ID) continue;
+				PacketType type = static_cast<PacketType>(r.Read(8));
+				if (type == PacketType::ACCEPT && !accepted) {
+					player = r.Read(8);
+					playerCount = std::min<size_t>(r.Read(8), MAX_PLAYERS);
+					if (r.Overflow() || player >= playerCount) continue;
+					for (size_t i = 0; i < playerCount; ++i) {
+						ships[i] = makeShip();
+					}
+					accepted = true;
+				}
+				else if (type == PacketType::SNAPSHOT && accepted) {
+					onSnapshot(r);
+				}
+			}
+		}
+
+		void onSnapshot(BitReader& r) {
+			uint32_t seq = r.Read(32);
+			uint32_t serverTick = r.Read(32);
+			uint32_t baseSeq = r.Read(32);
+			uint32_t lastInput = r.Read(32);
+			if (newestSeq != NONE && seq <= newestSeq) return;    // late or duplicate
+			const SnapshotRecord* base = nullptr;
+			if (baseSeq != NONE) {
+				base = &history[baseSeq % HISTORY];
+				if (base->seq != baseSeq) {
+					++stats.undecodable;
+					return;
+				}
+			}
+			score = static_cast<int>(r.Read(32));
+			kills = static_cast<int>(r.Read(32));
+
+			// the server had processed our input `lastInput`: half the round trip since we sent it is
+			// roughly how stale this snapshot is, so replicas are pushed forward by that much
+			uint32_t lead = 0;
+			if (lastInput != NONE && inputTick > lastInput && inputTick - lastInput < INPUT_BUFFER) {
+				lead = (inputTick - 1 - lastInput) / 2;
+				stats.roundTrip = (inputTick - 1 - lastInput) * TICK_DT;
+			}
+
+			size_t count = std::min<size_t>(r.Read(3), playerCount);
+			for (size_t i = 0; i < count; ++i) {
+				Vector2 position = { r.ReadSigned(16) * 0.25f, r.ReadSigned(16) * 0.25f };
+				int hp = static_cast<int>(r.Read(16));
+				bool alive = r.Read(1) != 0;
+				ShipInput input = UnpackInput(r.Read(8));
+				if (r.Overflow()) return;
+				ships[i]->SetState(position, hp, alive);
+				if (i == player) {
+					reconcile(lastInput);
+				}
+				else {
+					remoteInputs[i] = input;
+					for (uint32_t t = 0; t < lead; ++t) StepShip(*ships[i], input);
+				}
+			}
+
+			uint32_t removals = r.Read(6);
+			for (uint32_t i = 0; i < removals; ++i) {
+				replicas[r.Read(16)].active = false;
+			}
+
+			SnapshotRecord& record = history[seq % HISTORY];
+			record.Reset(seq, serverTick);
+			uint32_t ticks = base ? serverTick - base->tick : 0;
+			auto findBase = [base](uint16_t id) { return base ? base->Find(id) : nullptr; };
+			bool decoded = true;
+			while (decoded && r.Read(1) && !r.Overflow()) {
+				EntityState state;
+				decoded = ReadEntity(r, findBase, ticks, state) && !r.Overflow();
+				if (!decoded) break;
+				record.entities.push_back(state);
+
+				Replica& replica = replicas[state.id];
+				if (!replica.listed) activeIds.push_back(state.id);
+				replica.listed = true;
+				replica.active = true;
+				replica.state = state;
+				replica.position = StatePosition(state);
+				replica.velocity = StateVelocity(state);
+				replica.rotation = StateRotation(state);
+				advance(replica, lead * TICK_DT);
+			}
+			if (!decoded || r.Overflow()) {
+				record.seq = NONE;    // never ack or delta against a half-read snapshot
+				++stats.undecodable;
+				return;
+			}
+			record.Seal();
+			newestSeq = seq;
+			++stats.snapshots;
+		}
+
+		// Server state of the own ship as of input `lastInput`, then the inputs it has not seen yet on top
+		void reconcile(uint32_t lastInput) {
+			if (lastInput == NONE || inputTick <= lastInput || inputTick - lastInput >= INPUT_BUFFER) return;
+			Ship& own = *ships[player];
+			float error = Vector2Distance(own.GetPosition(), predicted[lastInput % INPUT_BUFFER]);
+			stats.predictionError += error;
+			stats.maxPredictionError = std::max(stats.maxPredictionError, error);
+			for (uint32_t t = lastInput + 1; t < inputTick; ++t) {
+				StepShip(own, inputs[t % INPUT_BUFFER]);
+				predicted[t % INPUT_BUFFER] = own.GetPosition();
+			}
+			stats.corrections += error > 0.5f ? 1 : 0;
+		}
+
+		Endpoint    endpoint;
+		Address     server;
+		ShipFactory makeShip;
+		Tuning      tuning;
+		bool        accepted = false;
+		uint32_t    connectTicks = 0;
+		size_t      player = 0;
+		size_t      playerCount = 0;
+		int         score = 0;
+		int         kills = 0;
+
+		std::array<std::unique_ptr<Ship>, MAX_PLAYERS> ships;
+		std::array<ShipInput, MAX_PLAYERS> remoteInputs{};
+
+		uint32_t inputTick = 0;
+		std::array<ShipInput, INPUT_BUFFER> inputs{};
+		std::array<Vector2, INPUT_BUFFER>   predicted{};
+
+		uint32_t newestSeq = NONE;
+		std::array<SnapshotRecord, HISTORY> history;
+		std::vector<Replica>  replicas;     // by id
+		std::vector<uint16_t> activeIds;
+
+		Stats stats;
+	};
+
+	// --- loopback session ---
+	struct SessionConfig {
+		int            players = 2;
+		LinkConditions link;
+		uint64_t       seed = 1;
+		Tuning         tuning;
+	};
+
+	// Server and all clients in one process, talking through real sockets on 127.0.0.1. Client 0 is the
+	// local player when Step gets an input, the rest are bots
+	class Session {
+	public:
+		bool Open(const SessionConfig& cfg, Client::ShipFactory localShip) {
+			config = cfg;
+			if (!server.Open(0, cfg.players, cfg.link, cfg.seed, cfg.tuning)) return false;
+			for (int i = 0; i < server.Players(); ++i) {
+				Client::ShipFactory factory = localShip;
+				if (i > 0 || !factory) factory = [] { return std::make_unique<HeadlessShip>(C_WIDTH, C_HEIGHT); };
+				auto client = std::make_unique<Client>();
+				if (!client->Open(server.GetAddress(), cfg.link, cfg.seed + 101 * uint64_t(i + 1), factory, cfg.tuning)) return false;
+				clients.push_back(std::move(client));
+			}
+			return true;
+		}
+
+		void Step(const ShipInput* local) {
+			for (size_t i = 0; i < clients.size(); ++i) {
+				Client& c = *clients[i];
+				ShipInput input = (i == 0 && local) ? *local : (c.Accepted() ? BotInput(c) : ShipInput{});
+				c.Tick(input, time);
+			}
+			server.Tick(time);
+			time += TICK_DT;
+		}
+
+		const Client& Local() const { return *clients[0]; }
+		const Client& GetClient(size_t i) const { return *clients[i]; }
+		size_t ClientCount() const { return clients.size(); }
+		const Server& GetServer() const { return server; }
+		Server& GetServer() { return server; }
+		double Time() const { return time; }
+
+		// what the session flies a client's ship with when no input is given for it
+		ShipInput BotInput(const Client& c) const {
+			size_t i = c.PlayerIndex();
+			Vector2 home = { C_WIDTH * float(i + 1) / float(c.PlayerCount() + 1), C_HEIGHT * 0.75f };
+			WeaponType weapon = static_cast<WeaponType>((i * 2) % WEAPON_COUNT);
+			const Ship& ship = c.OwnShip();
+			return Batch::SteerBot(ship.GetPosition(), ship.GetRadius(), home, weapon, [&](auto&& visit) { c.ForEachAsteroid(visit); });
+		}
+
+	private:
+		SessionConfig config;
+		Server server;
+		std::vector<std::unique_ptr<Client>> clients;
+		double time = 0.0;
+	};
+
+	// Shared by --net-test and --coop: [--players N] [--latency MS] [--jitter MS] [--loss PCT] [--seed S]
+	// [--fragments t,s,p,v] [--hp t,s,p,v] [--spawn min,max]; anything else is left to the caller through `extra`
+	template <typename Extra>
+	static bool ParseSessionArgs(int argc, char** argv, int first, SessionConfig& cfg, Extra&& extra) {
+		for (int i = first; i < argc; i += 2) {
+			if (i + 1 >= argc) return false;
+			const char* key = argv[i];
+			const char* val = argv[i + 1];
+			if (!strcmp(key, "--players")) cfg.players = atoi(val);
+			else if (!strcmp(key, "--latency")) cfg.link.latency = static_cast<float>(atof(val)) / 1000.f;
+			else if (!strcmp(key, "--jitter")) cfg.link.jitter = static_cast<float>(atof(val)) / 1000.f;
+			else if (!strcmp(key, "--loss")) cfg.link.loss = static_cast<float>(atof(val)) / 100.f;
+			else if (!strcmp(key, "--seed")) cfg.seed = strtoull(val, nullptr, 10);
+			else if (!strcmp(key, "--fragments")) {
+				if (!Batch::ParseList(val, cfg.tuning.fragments, 4)) return false;
+			}
+			else if (!strcmp(key, "--hp")) {
+				if (!Batch::ParseList(val, cfg.tuning.hp, 4)) return false;
+			}
+			else if (!strcmp(key, "--spawn")) {
+				if (!Batch::ParseList(val, cfg.tuning.spawnInterval, 2)) return false;
+			}
+			else if (!extra(key, val)) return false;
+		}
+		return cfg.players >= 1 && cfg.players <= static_cast<int>(MAX_PLAYERS) && cfg.link.jitter <= cfg.link.latency;
+	}
+
+	// Main.exe --net-test [session options] [--time S] [--flood S]
+	// Bot-only co-op over loopback, in two phases: normal play for --time seconds, then --flood seconds
+	// with asteroids spawning every few ticks until the world is at MAX_AST. Prints bandwidth, prediction
+	// and replication quality per client and phase, and fails (exit code 1) if a client never got in,
+	// a snapshot broke the budget, bandwidth went over the cap, replication fell behind in either
+	// phase or the flood never filled the world
+	static int Main(int argc, char** argv) {
+		SessionConfig cfg;
+		cfg.players = 3;
+		cfg.link = { 0.1f, 0.02f, 0.05f };
+		float duration = 60.f;
+		float flood = 30.f;
+		bool ok = ParseSessionArgs(argc, argv, 2, cfg, [&](const char* key, const char* val) {
+			if (!strcmp(key, "--time")) duration = static_cast<float>(atof(val));
+			else if (!strcmp(key, "--flood")) flood = static_cast<float>(atof(val));
+			else return false;
+			return true;
+		});
+		if (!ok) {
+			printf("usage: Main.exe --net-test [--players 1-4] [--time S] [--flood S] [--latency MS] [--jitter MS] [--loss PCT]\n"
+				"                     [--seed S] [--fragments t,s,p,v] [--hp t,s,p,v] [--spawn min,max]\n");
+			return 1;
+		}
+
+		Session session;
+		if (!session.Open(cfg, nullptr)) {
+			printf("net-test: cannot open sockets on 127.0.0.1\n");
+			return 1;
+		}
+
+		struct Sample {
+			uint64_t firstBytes = 0;
+			uint64_t lastBytes = 0;
+			uint64_t peakBytes = 0;       // per second
+			uint64_t seen = 0;            // server asteroids on screen for at least a second
+			uint64_t held = 0;            // ... that the client had a replica of
+			double   error = 0.0;
+		};
+		struct Phase {
+			const char*         name;
+			float               seconds;
+			std::vector<Sample> samples;
+			size_t              peakAsteroids = 0;
+			size_t              peakEntities = 0;
+		};
+		std::vector<uint32_t> firstSample(MAX_IDS, 0);
+		std::vector<uint32_t> lastSample(MAX_IDS, 0);
+		uint32_t sample = 0;
+
+		auto run = [&](Phase& phase) {
+			phase.samples.resize(session.ClientCount());
+			for (size_t c = 0; c < session.ClientCount(); ++c) {
+				phase.samples[c].firstBytes = phase.samples[c].lastBytes = session.GetClient(c).GetEndpoint().bytesReceived;
+			}
+			const int steps = static_cast<int>(phase.seconds / TICK_DT);
+			for (int step = 1; step <= steps; ++step) {
+				session.Step(nullptr);
+				const World* world = session.GetServer().GetWorld();
+				if (!world || step % 60 != 0) continue;
+
+				size_t entities = world->Asteroids().size() + world->Bonuses().size();
+				for (int k = 0; k < PROJECTILE_KIND_COUNT; ++k) entities += world->Projectiles(static_cast<ProjectileKind>(k)).size();
+				phase.peakEntities = std::max(phase.peakEntities, entities);
+				phase.peakAsteroids = std::max(phase.peakAsteroids, world->Asteroids().size());
+
+				// an asteroid counts once it has been on screen for a full sample, so it had time to get through
+				++sample;
+				for (const auto& a : world->Asteroids()) {
+					uint16_t id = a->NetId();
+					if (lastSample[id] != sample - 1) firstSample[id] = sample;
+					lastSample[id] = sample;
+				}
+				for (size_t c = 0; c < session.ClientCount(); ++c) {
+					const Client& client = session.GetClient(c);
+					Sample& s = phase.samples[c];
+					uint64_t bytes = client.GetEndpoint().bytesReceived;
+					s.peakBytes = std::max(s.peakBytes, bytes - s.lastBytes);
+					s.lastBytes = bytes;
+					for (const auto& a : world->Asteroids()) {
+						Vector2 p = a->GetPosition();
+						if (a->IsRemoved() || p.x < 0 || p.y < 0 || p.x > C_WIDTH || p.y > C_HEIGHT || firstSample[a->NetId()] == sample) continue;
+						++s.seen;
+						Vector2 replica;
+						if (client.Find(a->NetId(), replica)) {
+							++s.held;
+							s.error += Vector2Distance(replica, p);
+						}
+					}
+				}
+			}
+		};
+
+		std::vector<Phase> phases;
+		phases.push_back({ "normal", duration, {} });
+		if (flood > 0.f) phases.push_back({ "flood", flood, {} });
+
+		auto start = std::chrono::steady_clock::now();
+		for (Phase& phase : phases) {
+			if (!strcmp(phase.name, "flood") && session.GetServer().GetWorld()) {
+				session.GetServer().GetWorld()->SetSpawnInterval(FLOOD_SPAWN[0], FLOOD_SPAWN[1]);
+			}
+			run(phase);
+		}
+		double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		printf("net-test: %d players, %.0f s + %.0f s flood, latency %.0f ms +-%.0f, loss %.0f%%, %.2f s wall\n",
+			cfg.players, duration, flood, cfg.link.latency * 1000.f, cfg.link.jitter * 1000.f, cfg.link.loss * 100.f, wall);
+
+		int failures = 0;
+		const uint64_t bandwidthCap = static_cast<uint64_t>(SNAPSHOT_BUDGET) * (60 / SNAPSHOT_INTERVAL + 1);
+		for (const Phase& phase : phases) {
+			printf("%s phase: peak %zu entities (%zu asteroids), snapshot budget %d B at %u Hz\n",
+				phase.name, phase.peakEntities, phase.peakAsteroids, SNAPSHOT_BUDGET, 60u / SNAPSHOT_INTERVAL);
+			if (!strcmp(phase.name, "flood") && phase.peakAsteroids < World::MAX_AST / 2) {
+				printf("  FAIL: flood only reached %zu asteroids\n", phase.peakAsteroids);
+				++failures;
+			}
+			for (size_t c = 0; c < session.ClientCount(); ++c) {
+				const Sample& s = phase.samples[c];
+				double coverage = s.seen ? double(s.held) / double(s.seen) : 0.0;
+				printf("  client %zu: down %.1f kbit/s avg, %.1f peak | replicas: %.1f%% of settled on-screen asteroids, %.1f px off\n",
+					c, (s.lastBytes - s.firstBytes) * 8.0 / 1000.0 / phase.seconds, s.peakBytes * 8.0 / 1000.0,
+					coverage * 100.0, s.held ? s.error / double(s.held) : 0.0);
+				if (s.peakBytes > bandwidthCap || coverage < 0.95) {
+					printf("            FAIL\n");
+					++failures;
+				}
+			}
+		}
+
+		// own-ship prediction must average under 1 px per snapshot; only hits and lost inputs should make it miss
+		float total = duration + std::max(flood, 0.f);
+		for (size_t c = 0; c < session.ClientCount(); ++c) {
+			const Client& client = session.GetClient(c);
+			const Client::Stats& st = client.GetStats();
+			const Server::ClientStats& sv = session.GetServer().Stats(static_cast<int>(client.PlayerIndex()));
+			printf("client %zu: up %.1f kbit/s | %llu snapshots, %.0f entities each, max %d B\n"
+				"          prediction error %.2f px avg, %.1f max, %llu corrections, rtt %.0f ms, %llu inputs starved\n",
+				c, client.GetEndpoint().bytesSent * 8.0 / 1000.0 / total,
+				static_cast<unsigned long long>(st.snapshots), sv.snapshots ? double(sv.entitiesSent) / double(sv.snapshots) : 0.0, sv.maxSnapshotBytes,
+				st.snapshots ? st.predictionError / double(st.snapshots) : 0.0, st.maxPredictionError,
+				static_cast<unsigned long long>(st.corrections), st.roundTrip * 1000.f, static_cast<unsigned long long>(sv.inputsStarved));
+			if (!client.Accepted() || st.snapshots == 0 || sv.maxSnapshotBytes > SNAPSHOT_BUDGET || st.predictionError > double(st.snapshots)) {
+				printf("          FAIL\n");
+				++failures;
+			}
+		}
+		return failures > 0 ? 1 : 0;
+	}
+}
+
+// --- ASSET BUNDLE ---
+// Everything the game loads is baked offline into one indexed archive (Main.exe --pack, run by build.bat)
+// and memory-mapped at startup. Image entries are stored decoded, with their mip chain, in the pixel
+// format they upload in (DDS inputs stay GPU-compressed), so textures go to the GPU straight from the
+// mapped pages
+namespace Pack {
+	static constexpr char     MAGIC[4] = { 'A', 'P', 'A', 'K' };
+	static constexpr uint32_t VERSION = 1;
+	static constexpr uint64_t ALIGN = 4096;    // entry data starts on a page boundary
+	static constexpr int      NAME_LEN = 64;
+
+	enum class EntryType : uint32_t { RAW, IMAGE };
+
+	struct Header {
+		char     magic[4];
+		uint32_t version;
+		uint32_t count;
+		uint32_t reserved;
+	};
+
+	// index is sorted by name
+	struct Entry {
+		char      name[NAME_LEN];
+		EntryType type;
+		int32_t   width;
+		int32_t   height;
+		int32_t   mipmaps;
+		int32_t   format;       // PixelFormat for images
+		uint32_t  reserved;
+		uint64_t  offset;
+		uint64_t  size;
+	};
+
+	// Files the game loads, and the only ones packed: bundle name -> path relative to the repo root.
+	// Packing fails if one is missing; add an entry here when the game starts loading a new file
+	struct AssetSource {
+		const char* name;
+		const char* path;
+	};
+
+	static constexpr AssetSource REQUIRED_ASSETS[] = {
+		{ "ship.png", "source/spaceship1.png" },
+	};
+
+	// Bytes of an image including all of its mip levels
+	static int ImageDataSize(const Image& image) {
+		int total = 0;
+		int w = image.width;
+		int h = image.height;
+		for (int i = 0; i < image.mipmaps; ++i) {
+			total += GetPixelDataSize(w, h, image.format);
+			w = std::max(1, w / 2);
+			h = std::max(1, h / 2);
+		}
+		return total;
+	}
+
+	// Usage: Main.exe --pack <out.pak> <repo root>. Packs REQUIRED_ASSETS; any missing or undecodable
+	// file fails the pack
+	static int Main(int argc, char** argv) {
+		if (argc != 4) {
+			printf("usage: Main.exe --pack <out.pak> <repo root>\n");
+			return 1;
+		}
+		namespace fs = std::filesystem;
+		fs::path root = argv[3];
+
+		struct Input {
+			std::string name;
+			fs::path    path;
+		};
+		std::vector<Input> inputs;
+		int errors = 0;
+		for (const AssetSource& asset : REQUIRED_ASSETS) {
+			if (!fs::is_regular_file(root / asset.path)) {
+				printf("pack: missing required asset '%s' (%s)\n", asset.name, (root / asset.path).string().c_str());
+				++errors;
+			}
+			inputs.push_back({ asset.name, root / asset.path });
+		}
+		for (const Input& input : inputs) {
+			if (input.name.size() >= NAME_LEN) {
+				printf("pack: name too long '%s'\n", input.name.c_str());
+				++errors;
+			}
+		}
+		if (errors > 0) return 1;
+
+		std::sort(inputs.begin(), inputs.end(), [](const Input& a, const Input& b) { return a.name < b.name; });
+
+		// the archive is assembled in memory (page-aligned blobs after the index) and written in one go
+		std::vector<Entry> index(inputs.size());
+		Header header = { { MAGIC[0], MAGIC[1], MAGIC[2], MAGIC[3] }, VERSION, static_cast<uint32_t>(inputs.size()), 0 };
+		std::vector<unsigned char> archive(sizeof(Header) + sizeof(Entry) * index.size());
+
+		for (size_t i = 0; i < inputs.size(); ++i) {
+			const Input& input = inputs[i];
+			Entry& entry = index[i];
+			entry = {};
+			snprintf(entry.name, NAME_LEN, "%s", input.name.c_str());
+			std::string path = input.path.string();
+
+			const unsigned char* data = nullptr;
+			int size = 0;
+			Image image = {};
+			unsigned char* raw = nullptr;
+			if (IsFileExtension(path.c_str(), ".png;.bmp;.tga;.jpg;.dds")) {
+				image = LoadImage(path.c_str());
+				if (!IsImageReady(image)) {
+					printf("pack: cannot decode '%s'\n", path.c_str());
+					return 1;
+				}
+				if (image.format < PIXELFORMAT_COMPRESSED_DXT1_RGB && image.mipmaps == 1) {
+					ImageMipmaps(&image);
+				}
+				entry.type = EntryType::IMAGE;
+				entry.width = image.width;
+				entry.height = image.height;
+				entry.mipmaps = image.mipmaps;
+				entry.format = image.format;
+				data = static_cast<const unsigned char*>(image.data);
+				size = ImageDataSize(image);
+			}
+			else {
+				raw = LoadFileData(path.c_str(), &size);
+				if (!raw && size != 0) {
+					printf("pack: cannot read '%s'\n", path.c_str());
+					return 1;
+				}
+				entry.type = EntryType::RAW;
+				data = raw;
+			}
+
+			entry.offset = (archive.size() + ALIGN - 1) / ALIGN * ALIGN;
+			entry.size = static_cast<uint64_t>(size);
+			archive.resize(entry.offset + entry.size);
+			if (size > 0) memcpy(archive.data() + entry.offset, data, entry.size);
+
+			if (image.data) UnloadImage(image);
+			if (raw) UnloadFileData(raw);
+		}
+
+		// pad the tail so the last entry's page is complete in the file
+		archive.resize((archive.size() + ALIGN - 1) / ALIGN * ALIGN);
+		memcpy(archive.data(), &header, sizeof(Header));
+		memcpy(archive.data() + sizeof(Header), index.data(), sizeof(Entry) * index.size());
+
+		if (!SaveFileData(argv[2], archive.data(), static_cast<int>(archive.size()))) {
+			printf("pack: cannot write %s\n", argv[2]);
+			return 1;
+		}
+		printf("pack: %zu entries, %.1f MB -> %s\n", index.size(), archive.size() / (1024.0 * 1024.0), argv[2]);
+		return 0;
+	}
+}
+
+// Read-only view of a .pak mapped into memory
+class AssetBundle {
+public:
+	~AssetBundle() {
+		Close();
+	}
+
+	bool Open(const char* path) {
+		Close();
+#if defined(_WIN32)
+		file = CreateFileA(path, 0x80000000 /*GENERIC_READ*/, 1 /*FILE_SHARE_READ*/, nullptr, 3 /*OPEN_EXISTING*/, 0x80 /*FILE_ATTRIBUTE_NORMAL*/, nullptr);
+		if (file == reinterpret_cast<void*>(-1)) {
+			file = nullptr;
+			return false;
+		}
+		long long fileSize = 0;
+		GetFileSizeEx(file, &fileSize);
+		mapping = CreateFileMappingA(file, nullptr, 2 /*PAGE_READONLY*/, 0, 0, nullptr);
+		base = mapping ? static_cast<const unsigned char*>(MapViewOfFile(mapping, 4 /*FILE_MAP_READ*/, 0, 0, 0)) : nullptr;
+		size = static_cast<size_t>(fileSize);
+#else
+		int fd = open(path, O_RDONLY);
+		if (fd < 0) return false;
+		struct stat st {};
+		fstat(fd, &st);
+		size = static_cast<size_t>(st.st_size);
+		void* view = size > 0 ? mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+		close(fd);
+		base = view != MAP_FAILED ? static_cast<const unsigned char*>(view) : nullptr;
+#endif
+		if (!base || !valid()) {
+			TraceLog(LOG_WARNING, "ASSETS: %s is not a valid asset bundle", path);
+			Close();
+			return false;
+		}
+		TraceLog(LOG_INFO, "ASSETS: mapped %s, %u entries", path, header()->count);
+		return true;
+	}
+
+	void Close() {
+#if defined(_WIN32)
+		if (base) UnmapViewOfFile(base);
+		if (mapping) CloseHandle(mapping);
+		if (file) CloseHandle(file);
+		mapping = nullptr;
+		file = nullptr;
+#else
+		if (base) munmap(const_cast<unsigned char*>(base), size);
+#endif
+		base = nullptr;
+		size = 0;
+	}
+
+	bool IsOpen() const {
+		return base != nullptr;
+	}
+
+	const Pack::Entry* Find(const char* name) const {
+		if (!base) return nullptr;
+		const Pack::Entry* first = entries();
+		const Pack::Entry* last = first + header()->count;
+		const Pack::Entry* it = std::lower_bound(first, last, name,
+			[](const Pack::Entry& e, const char* n) { return strncmp(e.name, n, Pack::NAME_LEN) < 0; });
+		return (it != last && strncmp(it->name, name, Pack::NAME_LEN) == 0) ? it : nullptr;
+	}
+
+	const unsigned char* Data(const Pack::Entry& entry) const {
+		return base + entry.offset;
+	}
+
+	// Uploads a bundled image straight from the mapped pages. Without a bundle (e.g. a dev build run
+	// before packing) it falls back to the loose file
+	Texture2D LoadTexture(const char* name) const {
+		if (const Pack::Entry* entry = Find(name); entry && entry->type == Pack::EntryType::IMAGE) {
+			Image image = { const_cast<unsigned char*>(Data(*entry)), entry->width, entry->height, entry->mipmaps, entry->format };
+			return LoadTextureFromImage(image);
+		}
+		for (const Pack::AssetSource& asset : Pack::REQUIRED_ASSETS) {
+			if (!strcmp(asset.name, name)) {
+				TraceLog(LOG_WARNING, "ASSETS: '%s' not bundled, loading ../%s", name, asset.path);
+				Texture2D texture = ::LoadTexture(TextFormat("../%s", asset.path));
+				GenTextureMipmaps(&texture);
+				return texture;
+			}
+		}
+		TraceLog(LOG_WARNING, "ASSETS: unknown asset '%s'", name);
+		return Texture2D{};
+	}
+
+private:
+	const Pack::Header* header() const {
+		return reinterpret_cast<const Pack::Header*>(base);
+	}
+
+	const Pack::Entry* entries() const {
+		return reinterpret_cast<const Pack::Entry*>(base + sizeof(Pack::Header));
+	}
+
+	bool valid() const {
+		if (size < sizeof(Pack::Header) || memcmp(header()->magic, Pack::MAGIC, 4) != 0 || header()->version != Pack::VERSION) return false;
+		if (sizeof(Pack::Header) + sizeof(Pack::Entry) * uint64_t(header()->count) > size) return false;
+		for (uint32_t i = 0; i < header()->count; ++i) {
+			const Pack::Entry& e = entries()[i];
+			if (e.offset > size || e.size > size - e.offset || e.name[Pack::NAME_LEN - 1] != '\0') return false;
+		}
+		return true;
+	}
+
+	const unsigned char* base = nullptr;
+	size_t size = 0;
+#if defined(_WIN32)
+	void* file = nullptr;
+	void* mapping = nullptr;
+#endif
+};
+
+// --- FRAME PACING ---
+// raylib is built with SUPPORT_CUSTOM_FRAME_CONTROL, so EndDrawing() neither swaps, waits nor polls;
+// the application loop does WaitForFrame -> PollInputEvents -> update/draw -> SwapScreenBuffer -> FramePresented
+enum class PacingMode { UNCAPPED, VSYNC, TARGET_FPS, COUNT };
+
+// Millisecond histogram with fixed bins. Counts are halved every WINDOW samples so it follows recent frames
+class FrameHistogram {
+public:
+	void Add(double seconds) {
+		int bin = std::clamp(static_cast<int>(seconds * 1000.0 / BIN_MS), 0, BINS - 1);
+		++counts[bin];
+		if (++total >= WINDOW) {
+			total = 0;
+			for (int& c : counts) {
+				c /= 2;
+				total += c;
+			}
+		}
+	}
+
+	void Reset() {
+		std::fill(std::begin(counts), std::end(counts), 0);
+		total = 0;
+	}
+
+	// upper edge of the bin holding the p-th sample, in ms
+	float Percentile(float p) const {
+		int target = static_cast<int>(p * total);
+		int seen = 0;
+		for (int i = 0; i < BINS; ++i) {
+			seen += counts[i];
+			if (seen > target) return (i + 1) * BIN_MS;
+		}
+		return BINS * BIN_MS;
+	}
+
+	void Draw(int x, int y, const char* label, Color color) const {
+		int peak = *std::max_element(std::begin(counts), std::end(counts));
+		DrawRectangle(x, y, BINS * 3, GRAPH_H, Fade(BLACK, 0.5f));
+		for (int i = 0; i < BINS; ++i) {
+			int h = peak > 0 ? counts[i] * GRAPH_H / peak : 0;
+			DrawRectangle(x + i * 3, y + GRAPH_H - h, 2, h, color);
+		}
+		// 1 frame at 60 and 144 Hz for reference
+		DrawLine(x + static_cast<int>(16.7f / BIN_MS) * 3, y, x + static_cast<int>(16.7f / BIN_MS) * 3, y + GRAPH_H, DARKGRAY);
+		DrawLine(x + static_cast<int>(6.9f / BIN_MS) * 3, y, x + static_cast<int>(6.9f / BIN_MS) * 3, y + GRAPH_H, DARKGRAY);
+		DrawText(TextFormat("%s  p50 %.1f ms  p99 %.1f ms", label, Percentile(0.5f), Percentile(0.99f)), x, y + GRAPH_H + 4, 10, color);
+	}
+
+private:
+	static constexpr int   BINS = 100;
+	static constexpr float BIN_MS = 0.5f;
+	static constexpr int   WINDOW = 1200;
+	static constexpr int   GRAPH_H = 40;
+
+	int counts[BINS]{};
+	int total = 0;
+};
+
+class FramePacer {
+public:
+	void SetMode(PacingMode m) {
+		mode = m;
+		if (mode == PacingMode::VSYNC) SetWindowState(FLAG_VSYNC_HINT);
+		else ClearWindowState(FLAG_VSYNC_HINT);
+		deadline = 0.0;
+		frameTimes.Reset();
+		latencies.Reset();
+	}
+
+	PacingMode Mode() const {
+		return mode;
+	}
+
+	void SetTargetFps(int fps) {
+		targetFps = fps;
+		frameTimes.Reset();
+		latencies.Reset();
+	}
+
+	int TargetFps() const {
+		return targetFps;
+	}
+
+	// Target-FPS mode: sleeps until the last moment input can be sampled and the frame still be
+	// presented on schedule, using the measured input->present time of recent frames
+	void WaitForFrame() {
+		if (mode != PacingMode::TARGET_FPS) return;
+		double now = GetTime();
+		deadline = std::max(deadline + 1.0 / targetFps, now);    // don't try to catch up after a hitch
+		waitUntil(deadline - workEstimate - SAFETY);
+	}
+
+	// Call right after SwapScreenBuffer. inputTime is when PollInputEvents ran for this frame
+	void FramePresented(double inputTime) {
+		double now = GetTime();
+		if (lastPresent > 0.0) frameTimes.Add(now - lastPresent);
+		lastPresent = now;
+
+		// rises immediately on a slow frame, decays slowly, so late sampling rarely misses the deadline
+		double work = now - inputTime;
+		latencies.Add(work);
+		workEstimate = work > workEstimate ? work : workEstimate * 0.98 + work * 0.02;
+	}
+
+	void DrawOverlay(int x, int y) const {
+		static const char* MODE_NAMES[] = { "UNCAPPED", "VSYNC", "TARGET FPS" };
+		const char* name = MODE_NAMES[static_cast<int>(mode)];
+		if (mode == PacingMode::TARGET_FPS) {
+			DrawText(TextFormat("Pacing: %s %d  [F2 mode, F4 fps]", name, targetFps), x, y, 20, LIGHTGRAY);
+		}
+		else {
+			DrawText(TextFormat("Pacing: %s  [F2 mode, F4 fps]", name), x, y, 20, LIGHTGRAY);
+		}
+		frameTimes.Draw(x, y + 28, "frame time", SKYBLUE);
+		latencies.Draw(x, y + 88, "input -> present", ORANGE);
+	}
+
+private:
+	// Hybrid wait: 1 ms sleeps while the remaining time is larger than the worst recent oversleep,
+	// then a spin on the high-resolution clock for the rest
+	void waitUntil(double t) {
+		for (;;) {
+			double before = GetTime();
+			if (t - before <= sleepOvershoot + SPIN_MARGIN) break;
+			std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			double overshoot = GetTime() - before - 0.001;
+			sleepOvershoot = std::max(overshoot, sleepOvershoot * 0.99);
+		}
+		while (GetTime() < t) {
+		}
+	}
+
+	static constexpr double SAFETY = 0.0005;
+	static constexpr double SPIN_MARGIN = 0.0002;
 
-int main() {
+	PacingMode mode = PacingMode::TARGET_FPS;
+	int    targetFps = 60;
+	double deadline = 0.0;
+	double lastPresent = 0.0;
+	double workEstimate = 0.002;
+	double sleepOvershoot = 0.001;
+
+	FrameHistogram frameTimes;
+	FrameHistogram latencies;
+};
+
+// --- APPLICATION ---
+class Application {
+public:
+	static Application& Instance() {
+		static Application inst;
+		return inst;
+	}
+	// Streams the single-player World's events to `path` while playing
+	bool RecordTelemetry(const char* path) {
+		return telemetry.Open(path);
+	}
+
+	// Play through a loopback server with bot teammates instead of a local World
+	void EnableCoop(const Net::SessionConfig& cfg) {
+		coopConfig = cfg;
+		coopEnabled = true;
+	}
+	void Run() {
+		Startup();
+		NewWorld();
+		WeaponType currentWeapon = WeaponType::LASER;
+
+		// default to the display's refresh rate so high-refresh monitors get every frame
+		int refresh = GetMonitorRefreshRate(GetCurrentMonitor());
+		pacer.SetTargetFps(refresh > 0 ? refresh : 60);
+		pacer.SetMode(PacingMode::TARGET_FPS);
+		double lastInput = GetTime();
+
+		while (!WindowShouldClose()) {
+			// Sample input as late as possible, right before it is used
+			pacer.WaitForFrame();
+			heapFrame.Begin();
+			PollInputEvents();
+			double inputTime = GetTime();
+			float dt = static_cast<float>(inputTime - lastInput);
+			lastInput = inputTime;
+
+			// Frame pacing controls
+			if (IsKeyPressed(KEY_F2)) {
+				pacer.SetMode(static_cast<PacingMode>((static_cast<int>(pacer.Mode()) + 1) % static_cast<int>(PacingMode::COUNT)));
+			}
+			if (IsKeyPressed(KEY_F3)) {
+				showPacing = !showPacing;
+			}
+			if (IsKeyPressed(KEY_F4)) {
+				static constexpr int FPS_STEPS[] = { 60, 120, 144, 165, 240, 360 };
+				int next = FPS_STEPS[0];
+				for (int fps : FPS_STEPS) {
+					if (fps > pacer.TargetFps()) {
+						next = fps;
+						break;
+					}
+				}
+				pacer.SetTargetFps(next);
+			}
+			if (IsKeyPressed(KEY_F5)) {
+				Renderer::Instance().Lights().Toggle();
+			}
+
+			// Restart logic
+			if (!PlayerAlive() && IsKeyPressed(KEY_R)) {
+				NewWorld();
+			}
+			// Asteroid shape switch
+			if (IsKeyPressed(KEY_ONE)) {
+				currentShape = AsteroidShape::TRIANGLE;
+			}
+			if (IsKeyPressed(KEY_TWO)) {
+				currentShape = AsteroidShape::SQUARE;
+			}
+			if (IsKeyPressed(KEY_THREE)) {
+				currentShape = AsteroidShape::PENTAGON;
+			}
+			if (IsKeyPressed(KEY_FOUR)) {
+				currentShape = AsteroidShape::RANDOM;
+			}
+			if (IsKeyPressed(KEY_FIVE)) {
+				currentShape = AsteroidShape::VERYLARGE;
+			}
+			if (world) world->SetShape(currentShape);    // co-op spawns are the server's call
+
+			// Weapon switch
+			if (IsKeyPressed(KEY_TAB)) {
+				currentWeapon = static_cast<WeaponType>((static_cast<int>(currentWeapon) + 1) % static_cast<int>(WeaponType::COUNT));
+			}
+
+			ShipInput input;
+			input.up = IsKeyDown(KEY_W);
+			input.down = IsKeyDown(KEY_S);
+			input.left = IsKeyDown(KEY_A);
+			input.right = IsKeyDown(KEY_D);
+			input.fire = IsKeyDown(KEY_SPACE);
+			input.weapon = currentWeapon;
+
+			Update(dt, input);
+			Draw(currentWeapon);
+			SwapScreenBuffer();
+			pacer.FramePresented(inputTime);
+			heapFrame.End();
+
+			if (startupMs < 0.0) {
+				startupMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - startTime).count();
+				TraceLog(LOG_INFO, "STARTUP: first frame presented after %.1f ms (%s)", startupMs, assets.IsOpen() ? "asset bundle" : "loose files");
+			}
+		}
+		Shutdown();
+	}
+
+	// Main.exe --alloc-test, after Batch::AllocTest: the real frame loop in a hidden window, single player
+	// and then co-op over loopback. Bots fly, the weapon cycles every second, the F3 overlay is up and
+	// telemetry is recorded, so after WARMUP_FRAMES each of `frames` frames (simulation or session, lighting,
+	// starfield, HUD and overlay text, buffer swap) must stay off the heap; otherwise exit code 1
+	int AllocTest(int frames) {
+		static constexpr int WARMUP_FRAMES = 300;
+		static constexpr float DT = 1.f / 60.f;    // fixed, so both runs see the same frames
+
+		for (int& damage : tuning.baseDamage) damage = 0;    // no deaths, so no restart mid-loop
+		SetConfigFlags(FLAG_WINDOW_HIDDEN);
+		Startup();
+		if (!IsWindowReady()) {
+			printf("alloc-test: could not open a window for the frame loop\n");
+			return 1;
+		}
+		pacer.SetMode(PacingMode::UNCAPPED);
+		showPacing = true;
+		if (!telemetry.Open(ALLOC_TEST_TELEMETRY)) printf("alloc-test: could not record telemetry to %s\n", ALLOC_TEST_TELEMETRY);
+
+		int failures = 0;
+		auto play = [&](const char* name) {
+			NewWorld();
+			uint64_t allocs = 0;
+			uint64_t bytes = 0;
+			int dirty = 0;
+			int firstAt = -1;
+			for (int frame = 0; frame < WARMUP_FRAMES + frames; ++frame) {
+				WeaponType weapon = static_cast<WeaponType>(frame / 60 % WEAPON_COUNT);
+				pacer.WaitForFrame();
+				heapFrame.Begin();
+				PollInputEvents();
+				ShipInput input;
+				if (!session) input = Batch::BotInput(*world, weapon);
+				else if (session->Local().Accepted()) input = session->BotInput(session->Local());
+				input.weapon = weapon;
+				Update(DT, input);
+				Draw(weapon);
+				SwapScreenBuffer();
+				pacer.FramePresented(GetTime());
+				heapFrame.End();
+
+				if (frame < WARMUP_FRAMES || heapFrame.Last().allocs == 0) continue;
+				if (firstAt < 0) firstAt = frame;
+				++dirty;
+				allocs += heapFrame.Last().allocs;
+				bytes += heapFrame.Last().bytes;
+			}
+			printf("%-7s frame loop: %d frames after %d warmup, %d allocated (%llu allocs / %llu B)", name, frames, WARMUP_FRAMES,
+				dirty, static_cast<unsigned long long>(allocs), static_cast<unsigned long long>(bytes));
+			if (dirty > 0) {
+				printf("  FAIL, first at frame %d\n", firstAt);
+				++failures;
+			}
+			else {
+				printf("  ok\n");
+			}
+		};
+
+		play("single");
+		Net::SessionConfig cfg;
+		cfg.tuning = tuning;
+		EnableCoop(cfg);
+		play("co-op");
+		if (!session) {
+			printf("co-op frame loop fell back to single player\n");
+			++failures;
+		}
+
+		Shutdown();
+		remove(ALLOC_TEST_TELEMETRY);
+		return failures > 0 ? 1 : 0;
+	}
+
+private:
+	Application() = default;
+
+	static constexpr const char* ALLOC_TEST_TELEMETRY = "alloc-test.aev";
+
+	void Startup() {
+		{
+			Memory::Scope tag(Memory::Tag::RENDERING);
+			Renderer::Instance().Init(C_WIDTH, C_HEIGHT, "Asteroids OOP");
+		}
+		Memory::Scope tag(Memory::Tag::ASSETS);
+		assets.Open("assets.pak");
+		shipTexture = assets.LoadTexture("ship.png");
+		SetTextureFilter(shipTexture, TEXTURE_FILTER_TRILINEAR);
+	}
+
+	void Shutdown() {
+		session.reset();
+		world.reset();
+		telemetry.Close();
+		UnloadTexture(shipTexture);
+	}
+
+	// one frame of simulation: the co-op session's fixed ticks or the local World
+	void Update(float dt, const ShipInput& input) {
+		if (session) {
+			// the protocol runs on a fixed tick; render-rate frames just feed it
+			Memory::Scope tag(Memory::Tag::NETWORK);
+			coopAccumulator = std::min(coopAccumulator + dt, 5 * Net::TICK_DT);
+			while (coopAccumulator >= Net::TICK_DT) {
+				session->Step(&input);
+				coopAccumulator -= Net::TICK_DT;
+			}
+		}
+		else {
+			Memory::Scope tag(Memory::Tag::ENTITIES);
+			world->Tick(dt, input);
+			telemetry.Submit(world->TickEvents());
+		}
+	}
+
+	// the frame's scene, lit, then the HUD and F3 overlay on top
+	void Draw(WeaponType currentWeapon) {
+		Memory::Scope tag(Memory::Tag::RENDERING);
+		Renderer::Instance().Begin();
+
+		if (session) session->Local().Draw();
+		else world->Draw();
+
+		// projectiles and bonuses light the scene; the HUD below is drawn unlit
+		auto addLight = [](Vector2 position, float radius, Color color) { Renderer::Instance().AddLight(position, radius, color); };
+		if (session) session->Local().ForEachLight(addLight);
+		else world->ForEachLight(addLight);
+		Renderer::Instance().Resolve();
+
+		Memory::Scope text(Memory::Tag::TEXT);
+		DrawText(TextFormat("HP: %d", PlayerHP()),
+			10, 10, 20, GREEN);
+
+		const char* weaponName = tuning.weapons[static_cast<size_t>(currentWeapon)].name;
+		DrawText(TextFormat("Weapon: %s", weaponName),
+			10, 40, 20, BLUE);
+
+		DrawText(TextFormat("Score: %d", Score()), 10, 70, 20, YELLOW);
+		if (session && !session->Local().Accepted()) {
+			DrawText("Connecting...", C_WIDTH / 2 - MeasureText("Connecting...", 30) / 2, C_HEIGHT / 2, 30, LIGHTGRAY);
+		}
+
+		if (!PlayerAlive()) {
+			int score = Score();
+			DrawText("GAME OVER", C_WIDTH / 2 - MeasureText("GAME OVER", 60) / 2, C_HEIGHT / 2 - 30, 60, RED);
+			DrawText(TextFormat("Final Score: %d", score), C_WIDTH / 2 - MeasureText(TextFormat("Final Score: %d", score), 30) / 2, C_HEIGHT / 2 + 30, 30, YELLOW);
+			DrawText("Press [R] to Restart", C_WIDTH / 2 - MeasureText("Press [R] to Restart", 30) / 2, C_HEIGHT / 2 + 70, 30, WHITE);
+		}
+
+		if (showPacing) {
+			pacer.DrawOverlay(10, 100);
+			DrawText(TextFormat("Startup to first frame: %.0f ms", startupMs), 10, 250, 10, LIGHTGRAY);
+			heapFrame.DrawOverlay(10, 265);
+			Renderer::Instance().Lights().DrawOverlay(10, 352);
+			if (telemetry.IsOpen()) {
+				DrawText(TextFormat("Telemetry: %llu events, %.1f KB written, %llu dropped",
+					static_cast<unsigned long long>(telemetry.Written()), telemetry.Bytes() / 1024.0,
+					static_cast<unsigned long long>(telemetry.Dropped())), 10, 382, 10, LIGHTGRAY);
+			}
+			if (session) {
+				const Net::Client& local = session->Local();
+				const Net::Client::Stats& st = local.GetStats();
+				double kbps = session->Time() > 0.0 ? local.GetEndpoint().bytesReceived * 8.0 / 1000.0 / session->Time() : 0.0;
+				DrawText(TextFormat("Co-op: %d players  down %.1f kbit/s  rtt %.0f ms  prediction err %.2f px  corrections %llu",
+					static_cast<int>(local.PlayerCount()), kbps, st.roundTrip * 1000.f,
+					st.snapshots ? st.predictionError / double(st.snapshots) : 0.0, static_cast<unsigned long long>(st.corrections)),
+					10, 367, 10, LIGHTGRAY);
+			}
+		}
+
+		Renderer::Instance().End();
+	}
+
+	void NewWorld() {
+		uint64_t seed = static_cast<uint64_t>(time(nullptr)) + static_cast<uint64_t>(worldCount++);
+		if (coopEnabled) {
+			Memory::Scope tag(Memory::Tag::NETWORK);
+			Net::SessionConfig cfg = coopConfig;
+			cfg.seed += static_cast<uint64_t>(worldCount - 1);
+			session.reset();
+			session = std::make_unique<Net::Session>();
+			coopAccumulator = 0.f;
+			if (session->Open(cfg, [this] { return std::make_unique<PlayerShip>(C_WIDTH, C_HEIGHT, shipTexture); })) return;
+			TraceLog(LOG_WARNING, "COOP: could not open a loopback session, falling back to single player");
+			session.reset();
+			coopEnabled = false;
+		}
+		Memory::Scope tag(Memory::Tag::ENTITIES);
+		world.reset();
+		world = std::make_unique<World>(C_WIDTH, C_HEIGHT, seed, std::make_unique<PlayerShip>(C_WIDTH, C_HEIGHT, shipTexture), tuning);
+	}
+
+	// Until the server accepts us there is no ship to lose
+	bool PlayerAlive() const {
+		if (session) return !session->Local().Accepted() || session->Local().AnyAlive();
+		return world->Player().IsAlive();
+	}
+	int PlayerHP() const {
+		if (session) return session->Local().Accepted() ? session->Local().OwnShip().GetHP() : 0;
+		return world->Player().GetHP();
+	}
+	int Score() const { return session ? session->Local().Score() : world->Score(); }
+
+	std::unique_ptr<World> world;
+	std::unique_ptr<Net::Session> session;
+	Events::TelemetryWriter telemetry;
+	Net::SessionConfig coopConfig;
+	bool coopEnabled = false;
+	float coopAccumulator = 0.f;
+	Tuning tuning;
+	int worldCount = 0;
+
+	FramePacer pacer;
+	bool showPacing = false;
+	Memory::FrameCounter heapFrame;
+
+	AssetBundle assets;
+	Texture2D shipTexture{};
+	std::chrono::steady_clock::time_point startTime = std::chrono::steady_clock::now();    // Instance() is first touched in main
+	double startupMs = -1.0;
+
+	AsteroidShape currentShape = AsteroidShape::RANDOM;
+
+	static constexpr int C_WIDTH = 1600;
+	static constexpr int C_HEIGHT = 1600;
+};
+
+int main(int argc, char** argv) {
+	if (argc > 1 && !strcmp(argv[1], "--batch")) {
+		return Batch::Main(argc, argv);
+	}
+	if (argc > 1 && !strcmp(argv[1], "--alloc-test")) {
+		if constexpr (!Memory::ENABLED) {
+			printf("alloc-test: this build does not track allocations, rebuild with TRACK_ALLOCATIONS\n");
+			return 1;
+		}
+		else {
+			int frames = 600;
+			int result = Batch::AllocTest(argc, argv, frames);
+			return result != 0 ? result : Application::Instance().AllocTest(frames);
+		}
+	}
+	if (argc > 1 && !strcmp(argv[1], "--collision-bench")) {
+		return Batch::CollisionBench(argc, argv);
+	}
+	if (argc > 1 && !strcmp(argv[1], "--net-test")) {
+		return Net::Main(argc, argv);
+	}
+	if (argc > 1 && !strcmp(argv[1], "--pack")) {
+		return Pack::Main(argc, argv);
+	}
+	if (argc > 1 && !strcmp(argv[1], "--replay")) {
+		return Events::Replay(argc, argv);
+	}
+	if (argc > 1 && !strcmp(argv[1], "--telemetry")) {
+		// Main.exe --telemetry <file>: play normally and record every gameplay event
+		if (argc != 3 || !Application::Instance().RecordTelemetry(argv[2])) {
+			printf("usage: Main.exe --telemetry <file>\n");
+			return 1;
+		}
+	}
+	if (argc > 1 && !strcmp(argv[1], "--coop")) {
+		// Main.exe --coop [session options], see Net::ParseSessionArgs
+		Net::SessionConfig cfg;
+		if (!Net::ParseSessionArgs(argc, argv, 2, cfg, [](const char*, const char*) { return false; })) {
+			printf("usage: Main.exe --coop [--players 1-4] [--latency MS] [--jitter MS] [--loss PCT] [--seed S]\n"
+				"       [--fragments t,s,p,v] [--hp t,s,p,v] [--spawn min,max]\n");
+			return 1;
+		}
+		Application::Instance().EnableCoop(cfg);
+	}
 	Application::Instance().Run();
 	return 0;
 }